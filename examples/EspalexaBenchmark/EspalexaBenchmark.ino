@@ -0,0 +1,226 @@
+/*
+ * Measures the time Espalexa spends in its hot paths on the actual ESP.
+ * No WiFi connection is needed. Open the serial monitor at 115200 baud.
+ *
+ * The results are printed as one JSON object. Save it and paste it into `baseline` below,
+ * the next run will then add the change relative to it as a comment to every result.
+ * "ns" is the time per operation, "heap" the free heap lost per operation (leaks only,
+ * memory that is freed again within the operation can not be seen on the target).
+ * Batch color conversions additionally print "pxps", the pixels converted per second.
+ * "deviceSize" is sizeof(EspalexaDevice), "deviceHeap" the heap used per device added by name.
+ */
+#ifdef ARDUINO_ARCH_ESP32
+#include <WiFi.h>
+#else
+#include <ESP8266WiFi.h>
+#endif
+#ifdef ARDUINO_ARCH_ESP32
+#define ESPALEXA_MAXDEVICES 255 //the ESP8266 has not enough RAM for the JSON caches of 255 devices
+#else
+#define ESPALEXA_MAXDEVICES 50
+#endif
+#define ESPALEXA_TEST_HOOKS //single steps of Espalexa are measured through EspalexaTestHooks
+#include <Espalexa.h>
+#include <EspalexaTestHooks.h>
+#ifdef ARDUINO_ARCH_ESP32
+#include <EspalexaQueue.h> //needs <atomic>
+#endif
+
+//paste the output of a previous run here
+const char* baseline = R"()";
+
+Espalexa espalexa;
+EspalexaDevice* device;
+EspalexaGroup* room;
+uint32_t counter = 0;
+volatile uint32_t sink; //keeps the compiler from dropping unused results
+bool firstResult = true;
+
+void deviceChanged(EspalexaDevice*) {}
+void roomChanged(EspalexaGroup*) {}
+
+#define ROOM_LIGHTS 20 //lights switched by the room benchmarks
+
+void discard(void*, const char*, size_t) {}
+
+void lights(uint8_t count)
+{
+  char chunk[ESPALEXA_JSON_CHUNK];
+  EspalexaJsonWriter json(chunk, sizeof(chunk), discard, nullptr);
+  EspalexaTestHooks::renderLights(espalexa, json, count);
+  json.flush();
+}
+
+void deviceJson()
+{
+  char chunk[ESPALEXA_JSON_CHUNK];
+  EspalexaJsonWriter json(chunk, sizeof(chunk), discard, nullptr);
+  EspalexaTestHooks::renderDevice(espalexa, json, 1);
+  json.flush();
+}
+
+//switch a room of ROOM_LIGHTS with one request per light, like the Echo does without groups.
+//Only the Espalexa side is measured, every request also costs a TCP connection and HTTP parsing
+void roomByLights(const char* body)
+{
+  for (uint8_t i = 0; i < ROOM_LIGHTS; i++)
+  {
+    EspalexaCommand cmd;
+    cmd.parse(body, strlen(body));
+    EspalexaTestHooks::applyCommand(espalexa, espalexa.getDevice(i), cmd);
+  }
+  EspalexaTestHooks::updateDevices(espalexa);
+}
+
+//the same with one group request
+void roomByGroup(const char* body)
+{
+  EspalexaCommand cmd;
+  cmd.parse(body, strlen(body));
+  EspalexaTestHooks::applyGroupCommand(espalexa, room, cmd);
+  EspalexaTestHooks::updateDevices(espalexa);
+}
+
+//inputs and output of the batch color conversions. 10k pixels don't fit into RAM, so they are converted in 1k segments
+#define BATCH_PIXELS 1024
+uint16_t batchX[BATCH_PIXELS], batchY[BATCH_PIXELS], batchCt[BATCH_PIXELS];
+uint8_t batchSat[BATCH_PIXELS];
+uint32_t batchRgb[BATCH_PIXELS];
+
+const char* stateBody = "{\"on\":true,\"bri\":200,\"xy\":[0.3127,0.3290],\"transitiontime\":4}";
+const char* roomBodies[] = {"{\"on\":true,\"bri\":200}", "{\"on\":false}"};
+const char* searchPacket = "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 3\r\nST: urn:schemas-upnp-org:device:basic:1\r\n\r\n";
+
+void benchGetRgbCt()  {device->setColor((uint16_t)(153 + counter % 348)); sink = device->getRGB();}
+void benchGetRgbHs()  {device->setColor((uint16_t)(counter * 257), (uint8_t)(counter % 255)); sink = device->getRGB();}
+void benchGetRgbXy()  {device->setColorXY(0.15 + (counter % 50) * 0.01, 0.30); sink = device->getRGB();}
+void benchSetRgb()    {device->setColor((uint8_t)counter, (uint8_t)(counter >> 2), (uint8_t)(255 - counter));}
+void benchDevice()    {deviceJson();}
+void benchDeviceDirty() {device->setValue(1 + counter % 254); deviceJson();}
+void benchLights1()   {lights(1);}
+void benchLights10()  {lights(10);}
+void benchLights50()  {lights(50);}
+void benchLights255() {lights(255);}
+void benchParse()     {EspalexaCommand cmd; cmd.parse(stateBody, strlen(stateBody)); sink = cmd.fields;}
+void benchBatchHs()   {EspalexaColor::hs(batchX, batchSat, batchRgb, BATCH_PIXELS);}
+void benchBatchXy()   {EspalexaColor::xy(batchX, batchY, batchRgb, BATCH_PIXELS);}
+void benchBatchCt()   {EspalexaColor::ct(batchCt, batchRgb, BATCH_PIXELS);}
+void benchBatchHs10k() {for (uint8_t i = 0; i < 10; i++) benchBatchHs();}
+void benchBatchXy10k() {for (uint8_t i = 0; i < 10; i++) benchBatchXy();}
+void benchBatchCt10k() {for (uint8_t i = 0; i < 10; i++) benchBatchCt();}
+#ifdef ARDUINO_ARCH_ESP32
+//one command through the ESPALEXA_COMMAND_QUEUE ring, 1000000000 / ns is the throughput in commands per second
+EspalexaQueue<EspalexaCommand, 16> commandQueue;
+void benchQueue()     {EspalexaCommand cmd; cmd.bri = counter; commandQueue.push(cmd); commandQueue.pop(cmd); sink = cmd.bri;}
+#endif
+void benchRoomLights() {roomByLights(roomBodies[counter & 1]);}
+void benchRoomGroup()  {roomByGroup(roomBodies[counter & 1]);}
+void benchSearch()    {sink = EspalexaTestHooks::matchSearch(espalexa, searchPacket) == 3;}
+void benchSearchResponse() {EspalexaTestHooks::renderDiscovery(espalexa);}
+
+//previous result of a benchmark from the baseline, 0 if there is none
+uint32_t baselineNs(const char* name)
+{
+  char key[40];
+  snprintf(key, sizeof(key), "\"%s\":{\"ns\":", name);
+  const char* p = strstr(baseline, key);
+  if (p == nullptr) return 0;
+  return atol(p + strlen(key));
+}
+
+void bench(const char* name, void (*op)(), uint16_t iterations, uint32_t pixels = 0)
+{
+  op(); //warm up caches
+  uint32_t heap = ESP.getFreeHeap();
+  uint32_t start = ESP.getCycleCount();
+  for (uint16_t i = 0; i < iterations; i++, counter++) op();
+  uint32_t cycles = ESP.getCycleCount() - start;
+  int32_t heapLost = (int32_t)(heap - ESP.getFreeHeap()) / iterations;
+  uint32_t ns = (uint64_t)cycles * 1000 / ESP.getCpuFreqMHz() / iterations;
+
+  Serial.print(firstResult ? "\n  \"" : ",\n  \"");
+  firstResult = false;
+  Serial.print(name);
+  Serial.print("\":{\"ns\":");
+  Serial.print(ns);
+  Serial.print(",\"heap\":");
+  Serial.print(heapLost);
+  if (pixels)
+  {
+    Serial.print(",\"pxps\":");
+    Serial.print((uint32_t)((uint64_t)pixels * 1000000000 / ns));
+  }
+  Serial.print("}");
+  uint32_t old = baselineNs(name);
+  if (old)
+  {
+    Serial.print(" /* ");
+    Serial.print(((int32_t)ns - (int32_t)old) * 100.0 / old, 1);
+    Serial.print("% */");
+  }
+  yield();
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(1000);
+
+  uint32_t heap = ESP.getFreeHeap();
+  for (int i = 0; i < ESPALEXA_MAXDEVICES; i++)
+  {
+    espalexa.addDevice("Light " + String(i+1), deviceChanged, EspalexaDeviceType::extendedcolor, i);
+  }
+  uint32_t deviceHeap = (heap - ESP.getFreeHeap()) / ESPALEXA_MAXDEVICES;
+  device = espalexa.getDevice(0);
+  room = new EspalexaGroup("Room", roomChanged);
+  for (uint8_t i = 0; i < ROOM_LIGHTS; i++) room->addDevice(espalexa.getDevice(i));
+  espalexa.addGroup(room);
+  for (uint16_t i = 0; i < BATCH_PIXELS; i++)
+  {
+    batchX[i] = 5000 + i * 40; //0.08-0.7, also used as hue
+    batchY[i] = 60000 - i * 40;
+    batchSat[i] = i;
+    batchCt[i] = EspalexaColor::CT_MIN + i % (EspalexaColor::CT_MAX - EspalexaColor::CT_MIN);
+  }
+
+  Serial.print("{\"cpuMHz\":");
+  Serial.print(ESP.getCpuFreqMHz());
+  Serial.print(",\"deviceSize\":");
+  Serial.print(sizeof(EspalexaDevice));
+  Serial.print(",\"deviceHeap\":");
+  Serial.print(deviceHeap);
+  Serial.print(",\"results\":{");
+  bench("getRGB_ct", benchGetRgbCt, 1000);
+  bench("getRGB_hs", benchGetRgbHs, 1000);
+  bench("getRGB_xy", benchGetRgbXy, 1000);
+  bench("setColor_rgb", benchSetRgb, 1000);
+  bench("deviceJson", benchDevice, 500);
+  bench("deviceJson_changed", benchDeviceDirty, 500);
+  bench("lights_1", benchLights1, 200);
+  bench("lights_10", benchLights10, 50);
+  bench("lights_50", benchLights50, 10);
+  #if ESPALEXA_MAXDEVICES >= 255
+  bench("lights_255", benchLights255, 4);
+  #endif
+  bench("batch_hs_1k", benchBatchHs, 20, BATCH_PIXELS);
+  bench("batch_hs_10k", benchBatchHs10k, 2, BATCH_PIXELS * 10);
+  bench("batch_xy_1k", benchBatchXy, 20, BATCH_PIXELS);
+  bench("batch_xy_10k", benchBatchXy10k, 2, BATCH_PIXELS * 10);
+  bench("batch_ct_1k", benchBatchCt, 20, BATCH_PIXELS);
+  bench("batch_ct_10k", benchBatchCt10k, 2, BATCH_PIXELS * 10);
+  bench("parse_state", benchParse, 1000);
+  bench("room_20_lights", benchRoomLights, 100);
+  bench("room_20_group", benchRoomGroup, 100);
+  #ifdef ARDUINO_ARCH_ESP32
+  bench("queue_push_pop", benchQueue, 1000);
+  #endif
+  bench("msearch_match", benchSearch, 1000);
+  bench("search_response", benchSearchResponse, 200);
+  Serial.println("\n}}");
+}
+
+void loop()
+{
+  delay(1000);
+}
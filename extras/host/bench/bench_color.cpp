@@ -0,0 +1,39 @@
+//ns per color conversion, lookup tables and fixed point (EspalexaColor) against the float code getRGB() used before.
+//On the host both have an FPU, the difference is much larger on the ESP8266 (see examples/EspalexaBenchmark)
+
+#include <EspalexaColor.h>
+#include "color_reference.h"
+#include <chrono>
+#include <stdio.h>
+
+static volatile uint32_t sink;
+
+template <typename F> static double bench(F f)
+{
+  const uint32_t iterations = 1000000;
+  uint32_t acc = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) acc += f(i);
+  sink = acc;
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static void compare(const char* name, double table, double reference)
+{
+  printf("%-6s %7.1f ns table %7.1f ns float %5.1fx\n", name, table, reference, reference / table);
+}
+
+int main()
+{
+  //mired values without the five fixed Alexa colors
+  auto mired = [](uint32_t i) {return (uint16_t)(153 + (i * 7) % 348);};
+  compare("ct", bench([&](uint32_t i) {return EspalexaColor::ct(mired(i));}),
+                bench([&](uint32_t i) {return referenceCt(mired(i));}));
+  compare("gamma", bench([](uint32_t i) {return (uint32_t)EspalexaColor::gamma(i * 2654435761u >> 16);}),
+                   bench([](uint32_t i) {return (uint32_t)(255.0f * referenceGamma((i * 2654435761u >> 16) / 65535.0f));}));
+  compare("hs", bench([](uint32_t i) {return EspalexaColor::hs(i * 40503, i);}),
+                bench([](uint32_t i) {return referenceHs(i * 40503, i);}));
+  compare("xy", bench([](uint32_t i) {return EspalexaColor::xy(10000 + i % 30000, 10000 + (i * 7) % 25000);}),
+                bench([](uint32_t i) {return referenceXy((10000 + i % 30000) / 65535.0f, (10000 + (i * 7) % 25000) / 65535.0f, referenceHueWide);}));
+  return 0;
+}
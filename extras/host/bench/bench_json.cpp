@@ -0,0 +1,122 @@
+//µs and heap allocations per /lights and single light response, for the streamed responses and for the String concatenation
+//the library used before (rebuilt here from the public device getters). Built for the sync and the async server,
+//the allocations include those of the server stand-in (the async request and response objects)
+
+#include <Espalexa.h>
+#include "alloc_count.h"
+#include <chrono>
+
+#ifdef ESPALEXA_ASYNC
+AsyncWebServer server(80);
+#else
+WebServer server(80);
+#endif
+Espalexa espalexa;
+
+static void onChange(EspalexaDevice*) {}
+
+//the members of the old EspalexaDevice, to compare the memory per device
+struct OldDevice {
+  String _deviceName;
+  BrightnessCallbackFunction _callback = nullptr;
+  DeviceCallbackFunction _callbackDev = nullptr;
+  ColorCallbackFunction _callbackCol = nullptr;
+  uint8_t _val, _val_last, _sat = 0;
+  uint16_t _hue = 0, _ct = 0;
+  float _x = 0.5, _y = 0.5;
+  uint32_t _rgb = 0;
+  uint8_t _id = 0;
+  EspalexaDeviceType _type;
+  EspalexaDeviceProperty _changed = EspalexaDeviceProperty::none;
+  EspalexaColorMode _mode = EspalexaColorMode::xy;
+};
+
+//the old deviceJsonString()
+static String concatDevice(EspalexaDevice* dev, uint32_t id)
+{
+  String json = "{\"state\":{\"on\":";
+  json += dev->getValue() ? "true" : "false";
+  json += ",\"bri\":" + String(dev->getLastValue()-1);
+  json += ",\"hue\":" + String(dev->getHue()) + ",\"sat\":" + String(dev->getSat());
+  json += ",\"effect\":\"none\",\"xy\":[" + String(dev->getX()) + "," + String(dev->getY()) + "]";
+  json += ",\"ct\":" + String(dev->getCt());
+  json += ",\"alert\":\"none";
+  json += "\",\"colormode\":\"xy";
+  json += "\",\"mode\":\"homeautomation\",\"reachable\":true},";
+  json += "\"type\":\"Extended color light";
+  json += "\",\"name\":\"" + dev->getName();
+  json += "\",\"modelid\":\"LCT015";
+  json += "\",\"manufacturername\":\"Philips\",\"productname\":\"E4";
+  json += "\",\"uniqueid\":\"" + String((unsigned long)id);
+  json += "\",\"swversion\":\"espalexa-2.4.4\"}";
+  return json;
+}
+
+static size_t concatLights(uint8_t count)
+{
+  String jsonTemp = "{";
+  for (int i = 0; i < count; i++)
+  {
+    jsonTemp += "\"" + String(i+1) + "\":";
+    jsonTemp += concatDevice(espalexa.getDevice(i), i+1);
+    if (i < count-1) jsonTemp += ",";
+  }
+  jsonTemp += "}";
+  return jsonTemp.length();
+}
+
+template <typename F> static void bench(const char* name, uint8_t devices, F f)
+{
+  const int iterations = 200;
+  f(); //warm up the caches
+  long allocations = hostAllocations();
+  size_t len = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) len = f();
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+  printf("%-14s %3u lights %7zu bytes %9.1f us %7.1f allocations\n", name, devices, len, us, (double)(hostAllocations() - allocations) / iterations);
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  #ifdef ESPALEXA_ASYNC
+  server.onNotFound([](AsyncWebServerRequest* request) {espalexa.handleAlexaApiCall(request);});
+  const char* mode = "async";
+  #else
+  server.onNotFound([]() {espalexa.handleAlexaApiCall(server.uri(), server.arg(0));});
+  const char* mode = "sync";
+  #endif
+  for (int i = 0; i < 255; i++) espalexa.addDevice("Light " + String(i), onChange, EspalexaDeviceType::extendedcolor, i);
+  espalexa.begin(&server);
+
+  //both keep the name in a String, so its heap block is the same
+  printf("EspalexaDevice %zu bytes, before %zu bytes, 255 lights %zu bytes, before %zu bytes\n\n",
+    sizeof(EspalexaDevice), sizeof(OldDevice), 255 * sizeof(EspalexaDevice), 255 * sizeof(OldDevice));
+
+  printf("/lights responses, %s server\n", mode);
+  for (uint8_t count : {1, 16, 50, 100, 255})
+  {
+    //a listing always has all devices, so each count gets its own Espalexa
+    Espalexa* e = new Espalexa();
+    for (int i = 0; i < count; i++) e->addDevice(espalexa.getDevice(i));
+    #ifdef ESPALEXA_ASYNC
+    AsyncWebServer s(80);
+    s.onNotFound([e](AsyncWebServerRequest* request) {e->handleAlexaApiCall(request);});
+    e->begin(&s);
+    auto get = [&](const char* url) {AsyncWebServerRequest* r = s.inject(HTTP_GET, url); size_t n = r->responseBody(1460).size(); delete r; return n;};
+    #else
+    WebServer s(80);
+    s.onNotFound([e, &s]() {e->handleAlexaApiCall(s.uri(), s.arg(0));});
+    e->begin(&s);
+    auto get = [&](const char* url) {s.inject(HTTP_GET, url); return s.responseBody().size();};
+    #endif
+    char last[32];
+    snprintf(last, sizeof(last), "/api/u/lights/%u", count);
+    bench("streamed", count, [&]() {return get("/api/u/lights");});
+    bench("concatenated", count, [&]() {return concatLights(count);});
+    bench("last light", count, [&]() {return get(last);});
+    delete e;
+  }
+  return 0;
+}
@@ -0,0 +1,35 @@
+//parsed Hue state bodies per second and heap allocations per body
+
+#include <EspalexaCommand.h>
+#include "alloc_count.h"
+#include <chrono>
+
+static const char* bodies[] = {
+  "{\"on\":true}",
+  "{\"on\":true,\"bri\":200}",
+  "{\"xy\":[0.6750,0.3220],\"transitiontime\":4}",
+  "{\"hue\":46920,\"sat\":254,\"bri\":127}",
+  "{\"ct\":383,\"effect\":\"none\",\"alert\":\"none\",\"on\":true}",
+};
+
+int main()
+{
+  const int iterations = 1000000;
+  for (const char* body : bodies)
+  {
+    size_t len = strlen(body);
+    EspalexaCommand cmd;
+    uint32_t sum = 0;
+    long allocations = hostAllocations();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+      cmd.parse(body, len);
+      sum += cmd.fields + cmd.bri + cmd.x;
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-55s %6.1f M bodies/s %4.1f allocations/body (%u)\n", body, iterations / s / 1e6,
+      (double)(hostAllocations() - allocations) / iterations, sum & 1);
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+//ESPALEXA_COMMAND_QUEUE throughput: commands per second through EspalexaQueue with the producer and consumer on one
+//and on two threads, the same for whole requests (parse, queue, apply), and state copies through EspalexaSeqlockBuffer
+
+#include <Espalexa.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+AsyncWebServer server(80);
+Espalexa espalexa;
+
+static void onChange(EspalexaDevice*) {}
+
+static double seconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  const uint32_t count = 2000000;
+  struct Command {
+    uint8_t slot, group;
+    EspalexaCommand cmd;
+  };
+
+  {
+    EspalexaQueue<Command, 16> queue;
+    Command c = {}, out;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) {c.slot = i; queue.push(c); queue.pop(out);}
+    printf("queue, one thread    %6.1f M commands/s\n", count / seconds(start) / 1e6);
+  }
+  {
+    EspalexaQueue<Command, 16> queue;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+      Command c = {};
+      for (uint32_t i = 0; i < count;)
+      {
+        if (queue.push(c)) i++;
+        else std::this_thread::yield(); //the host may have a single core
+      }
+    });
+    Command out;
+    for (uint32_t i = 0; i < count;)
+    {
+      if (queue.pop(out)) i++;
+      else std::this_thread::yield();
+    }
+    producer.join();
+    printf("queue, two threads   %6.1f M commands/s\n", count / seconds(start) / 1e6);
+  }
+  {
+    EspalexaSeqlockBuffer<ESPALEXA_STATE_CACHE> buffer;
+    char state[ESPALEXA_STATE_CACHE];
+    memset(state, 'x', sizeof(state));
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+      while (!done) {buffer.write(state, 150); std::this_thread::yield();}
+    });
+    char out[ESPALEXA_STATE_CACHE];
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) buffer.read(out);
+    double s = seconds(start);
+    done = true;
+    writer.join();
+    printf("state reads, writing %6.1f M reads/s\n", count / s / 1e6);
+  }
+
+  //whole requests: the network thread parses and queues, this thread applies them
+  server.onNotFound([](AsyncWebServerRequest* request) {espalexa.handleAlexaApiCall(request);});
+  for (int i = 0; i < 10; i++) espalexa.addDevice("Light " + String(i), onChange, EspalexaDeviceType::extendedcolor);
+  espalexa.begin(&server);
+  const uint32_t requests = 200000;
+  std::atomic<bool> done{false};
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::thread network([&]() {
+    char url[40];
+    for (uint32_t i = 0; i < requests; i++)
+    {
+      snprintf(url, sizeof(url), "/api/u/lights/%u/state", 1 + i % 10);
+      delete server.inject(HTTP_PUT, url, "{\"on\":true,\"bri\":100,\"hue\":1000,\"sat\":200}");
+      std::this_thread::yield();
+    }
+    done = true;
+  });
+  while (!done) {espalexa.processCommands(); std::this_thread::yield();}
+  network.join();
+  espalexa.processCommands();
+  printf("requests             %6.3f M requests/s, %u dropped\n", requests / seconds(start) / 1e6, espalexa.getDroppedCommands());
+  return 0;
+}
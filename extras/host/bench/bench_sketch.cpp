@@ -0,0 +1,9 @@
+//examples/EspalexaBenchmark on the host, so the sketch is built and run with every host build
+
+#include "../../../examples/EspalexaBenchmark/EspalexaBenchmark.ino"
+
+int main()
+{
+  setup();
+  return 0;
+}
@@ -0,0 +1,29 @@
+//The float conversions of color_reference.h as functions with the signatures of EspalexaColor, compiled on their own
+//so color_size.cmake can compare their code size with EspalexaColor.cpp
+
+#include "color_reference.h"
+
+uint32_t floatCt(uint16_t ct)
+{
+  return referenceCt(ct);
+}
+
+uint32_t floatHs(uint16_t hue, uint8_t sat)
+{
+  return referenceHs(hue, sat);
+}
+
+uint32_t floatXy(uint16_t x, uint16_t y, uint8_t gamut)
+{
+  return referenceGamutXy(x / 65535.0f, y / 65535.0f, referenceGamuts[gamut % 5]);
+}
+
+bool floatRgbToXy(uint8_t r, uint8_t g, uint8_t b, uint16_t& x, uint16_t& y, uint8_t gamut)
+{
+  if ((r | g | b) == 0) return false;
+  float fx, fy;
+  referenceRgbToXy(r, g, b, fx, fy, referenceGamuts[gamut % 5]);
+  x = fx * 65535.0f + 0.5f;
+  y = fy * 65535.0f + 0.5f;
+  return true;
+}
@@ -0,0 +1,56 @@
+# Code size of EspalexaColor.cpp against the float conversions it replaced (color_float.cpp), both built with -Os,
+# and a check that EspalexaColor.cpp has no floating point instructions or math library calls.
+#
+#   cmake -DSIZE=<size> -DOBJDUMP=<objdump> -DFIXED=<EspalexaColor.o> -DFLOAT=<color_float.o> -P color_size.cmake
+
+function(object_size object out)
+  execute_process(COMMAND ${SIZE} ${object} OUTPUT_VARIABLE result RESULT_VARIABLE failed)
+  if(failed OR NOT result MATCHES "\n[ \t]*([0-9]+)[ \t]")
+    message(FATAL_ERROR "size ${object} failed")
+  endif()
+  set(size "${CMAKE_MATCH_1} bytes code and constants")
+
+  # the library functions it calls, their size is not included (on the ESP8266 the software float and libm code is several KB)
+  execute_process(COMMAND ${OBJDUMP} -t ${object} OUTPUT_VARIABLE symbols)
+  string(REGEX MATCHALL "\\*UND\\*[^\n]*[ \t]([a-zA-Z_][a-zA-Z0-9_]*)\n" undefined "${symbols}")
+  set(calls "")
+  foreach(line ${undefined})
+    string(REGEX REPLACE ".*[ \t]([a-zA-Z_][a-zA-Z0-9_]*)\n" "\\1" name "${line}")
+    list(APPEND calls ${name})
+  endforeach()
+  if(calls)
+    string(REPLACE ";" ", " calls "${calls}")
+    set(size "${size}, calls ${calls}")
+  endif()
+  set(${out} "${size}" PARENT_SCOPE)
+endfunction()
+
+# x86 scalar and packed float instructions and the libm calls of the old code
+set(FLOAT_CODE "[ \t](cvt[a-z0-9]*|(add|sub|mul|div|sqrt|min|max|u?comi)(ss|sd|ps|pd))[ \t]|<(pow|powf|log|logf|floorf)[@>]")
+
+function(uses_float object out)
+  execute_process(COMMAND ${OBJDUMP} -dr ${object} OUTPUT_VARIABLE result RESULT_VARIABLE failed)
+  if(failed)
+    message(FATAL_ERROR "objdump ${object} failed")
+  endif()
+  if(result MATCHES "${FLOAT_CODE}")
+    set(${out} "${CMAKE_MATCH_0}" PARENT_SCOPE)
+  else()
+    set(${out} "" PARENT_SCOPE)
+  endif()
+endfunction()
+
+object_size(${FIXED} fixed)
+object_size(${FLOAT} float)
+message("EspalexaColor.cpp (with the batch functions) ${fixed}")
+message("float conversions                     ${float}")
+
+uses_float(${FLOAT} found)
+if(NOT found)
+  message(FATAL_ERROR "the float check doesn't find anything in color_float.cpp, FLOAT_CODE doesn't match this compiler")
+endif()
+uses_float(${FIXED} found)
+if(found)
+  message(FATAL_ERROR "EspalexaColor.cpp uses floating point: ${found}")
+endif()
+message("EspalexaColor.cpp has no floating point code")
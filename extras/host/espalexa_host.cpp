@@ -0,0 +1,33 @@
+//Espalexa on the host, serving until it is killed. Try it with e.g.
+//  curl http://127.0.0.1:8080/api/user/lights
+//  curl -X PUT -d '{"on":true,"bri":200,"transitiontime":10}' http://127.0.0.1:8080/api/user/lights/1/state
+//or send an M-SEARCH to 127.0.0.1:1900. Run it under perf, heaptrack or valgrind like any other program
+
+#include <Espalexa.h>
+
+Espalexa espalexa;
+
+static void onChange(EspalexaDevice* d)
+{
+  Serial.print(d->getNameCStr());
+  Serial.print(": value ");
+  Serial.print(d->getValue());
+  Serial.print(", rgb ");
+  Serial.println(String(d->getRGB(), 16));
+}
+
+int main()
+{
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  espalexa.addDevice("Light", onChange, EspalexaDeviceType::dimmable, 127);
+  espalexa.addDevice("White", onChange, EspalexaDeviceType::whitespectrum, 127);
+  espalexa.addDevice("Color", onChange, EspalexaDeviceType::extendedcolor, 127);
+  if (!espalexa.begin()) {Serial.println("begin() failed"); return 1;}
+  printf("listening on http://127.0.0.1:%u and udp port 1900\n", hostPort(80));
+  fflush(stdout);
+  for (;;)
+  {
+    espalexa.loop();
+    delay(1);
+  }
+}
@@ -0,0 +1,82 @@
+#include "Arduino.h"
+#include "WiFi.h"
+#include "HostNet.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+static std::atomic<bool> manualClock{false};
+static std::atomic<unsigned long> manualMillis{0};
+
+static uint64_t nanos()
+{
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long millis()
+{
+  if (manualClock) return manualMillis;
+  return nanos() / 1000000;
+}
+
+unsigned long micros()
+{
+  return nanos() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+  if (manualClock) {manualMillis += ms; return;}
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield()
+{
+  std::this_thread::yield();
+}
+
+void hostSetMillis(unsigned long ms)
+{
+  manualMillis = ms;
+  manualClock = true;
+}
+
+void hostAdvanceMillis(unsigned long ms)
+{
+  manualMillis += ms;
+  manualClock = true;
+}
+
+static std::minstd_rand& rng()
+{
+  static std::minstd_rand r(1);
+  return r;
+}
+
+long random(long max)
+{
+  return max > 0 ? (long)(rng()() % (unsigned long)max) : 0;
+}
+
+long random(long min, long max)
+{
+  return max > min ? min + random(max - min) : min;
+}
+
+uint32_t EspClass::getCycleCount()
+{
+  return (uint32_t)nanos();
+}
+
+uint16_t hostPort(uint16_t port)
+{
+  if (port >= 1024) return port;
+  const char* offset = getenv("ESPALEXA_HOST_PORT_OFFSET");
+  return port + (offset ? atoi(offset) : 8000);
+}
@@ -0,0 +1,76 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+//host stand-in for the parts of the ESP32 Arduino core Espalexa uses
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include "WString.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT 0
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define snprintf_P snprintf
+#define sprintf_P sprintf
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+long random(long max);
+long random(long min, long max);
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+//host only: millis() follows the real clock until hostSetMillis() is called, then it only moves with these
+void hostSetMillis(unsigned long ms);
+void hostAdvanceMillis(unsigned long ms);
+
+class HardwareSerial {
+public:
+  void begin(unsigned long) {}
+  operator bool() const {return true;}
+  size_t print(const char* s) {return fputs(s, stdout) < 0 ? 0 : strlen(s);}
+  size_t print(const String& s) {return print(s.c_str());}
+  size_t print(char c) {return putchar(c) == EOF ? 0 : 1;}
+  size_t print(int v) {return printf("%d", v);}
+  size_t print(unsigned int v) {return printf("%u", v);}
+  size_t print(long v) {return printf("%ld", v);}
+  size_t print(unsigned long v) {return printf("%lu", v);}
+  size_t print(double v, int decimals = 2) {return printf("%.*f", decimals, v);}
+  template <typename T> size_t println(T v) {size_t n = print(v); return n + println();}
+  size_t println(double v, int decimals) {size_t n = print(v, decimals); return n + println();}
+  size_t println() {return print('\n');}
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+  uint32_t getFreeHeap() {return 0;} //use the malloc counters of the host tests instead
+  uint32_t getCycleCount(); //nanoseconds on the host
+  uint32_t getCpuFreqMHz() {return 1000;}
+};
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef AsyncTCP_h
+#define AsyncTCP_h
+
+//nothing to declare on the host, see ESPAsyncWebServer.h
+
+#endif
@@ -0,0 +1,75 @@
+#include "ESPAsyncWebServer.h"
+
+void AsyncWebServerRequest::send(int code, const String& type, const String& content)
+{
+  AsyncWebServerResponse* r = new AsyncWebServerResponse(code, type);
+  r->_content.assign(content.c_str(), content.length());
+  send(r);
+}
+
+void AsyncWebServerRequest::send_P(int code, const String& type, const uint8_t* content, size_t len)
+{
+  AsyncWebServerResponse* r = new AsyncWebServerResponse(code, type);
+  r->_content.assign((const char*)content, len);
+  send(r);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const String& type, AwsResponseFiller filler)
+{
+  AsyncWebServerResponse* r = new AsyncWebServerResponse(200, type);
+  r->_filler = filler;
+  return r;
+}
+
+size_t AsyncWebServerRequest::readResponse(uint8_t* buffer, size_t maxLen)
+{
+  if (_response == nullptr || _response->_done || maxLen == 0) return 0;
+  size_t n;
+  if (_response->_filler)
+  {
+    n = _response->_filler(buffer, maxLen, _response->_sent);
+  } else {
+    n = std::min(maxLen, _response->_content.size() - _response->_sent);
+    memcpy(buffer, _response->_content.data() + _response->_sent, n);
+  }
+  _response->_sent += n;
+  if (n == 0) _response->_done = true;
+  return n;
+}
+
+std::string AsyncWebServerRequest::responseBody(size_t window)
+{
+  std::string body;
+  std::vector<uint8_t> buffer(window);
+  while (size_t n = readResponse(buffer.data(), window)) body.append((const char*)buffer.data(), n);
+  return body;
+}
+
+AsyncWebServerRequest* AsyncWebServer::inject(WebRequestMethodComposite method, const char* url, const char* body, size_t bodyChunk)
+{
+  size_t total = strlen(body);
+  AsyncWebServerRequest* request = openRequest(method, url, total);
+  for (size_t i = 0; i < total; i += bodyChunk) receiveBody(request, body + i, std::min(bodyChunk, total - i), i);
+  handleRequest(request);
+  return request;
+}
+
+AsyncWebServerRequest* AsyncWebServer::openRequest(WebRequestMethodComposite method, const char* url, size_t contentLength)
+{
+  return new AsyncWebServerRequest(method, url, contentLength);
+}
+
+void AsyncWebServer::receiveBody(AsyncWebServerRequest* request, const char* data, size_t len, size_t index)
+{
+  if (_body) _body(request, (uint8_t*)data, len, index, request->contentLength());
+}
+
+void AsyncWebServer::handleRequest(AsyncWebServerRequest* request)
+{
+  for (const Route& r : _routes)
+  {
+    if (r.uri == request->url() && (r.method & request->method())) {r.fn(request); return;}
+  }
+  if (_notFound) _notFound(request);
+  else request->send(404);
+}
@@ -0,0 +1,129 @@
+#ifndef ESPAsyncWebServer_h
+#define ESPAsyncWebServer_h
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "WiFi.h"
+
+//the parts of the ESPAsyncWebServer API Espalexa uses. There is no socket: tests hand requests to inject(),
+//from any thread they like (on the ESP the handlers run on the AsyncTCP task), and read the response from the request
+
+typedef enum {
+  HTTP_GET = 0b00000001, HTTP_POST = 0b00000010, HTTP_DELETE = 0b00000100, HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000, HTTP_HEAD = 0b00100000, HTTP_OPTIONS = 0b01000000, HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+class AsyncWebParameter {
+private:
+  String _name, _value;
+  bool _post;
+
+public:
+  AsyncWebParameter(const String& name, const String& value, bool post) : _name(name), _value(value), _post(post) {}
+  const String& name() const {return _name;}
+  const String& value() const {return _value;}
+  bool isPost() const {return _post;}
+};
+
+class AsyncWebServerResponse {
+private:
+  friend class AsyncWebServerRequest;
+  int _code = 200;
+  std::string _type, _content;
+  AwsResponseFiller _filler;
+  size_t _sent = 0;
+  bool _done = false;
+
+public:
+  AsyncWebServerResponse(int code, const String& type) : _code(code), _type(type.c_str()) {}
+};
+
+class AsyncWebServerRequest {
+public:
+  void* _tempObject = nullptr; //freed with free() when the request is deleted, like in ESPAsyncWebServer
+
+  AsyncWebServerRequest(WebRequestMethodComposite method, const String& url, size_t contentLength)
+    : _method(method), _url(url), _contentLength(contentLength) {}
+  ~AsyncWebServerRequest() {free(_tempObject); delete _response;}
+  AsyncWebServerRequest(const AsyncWebServerRequest&) = delete;
+  AsyncWebServerRequest& operator=(const AsyncWebServerRequest&) = delete;
+
+  WebRequestMethodComposite method() const {return _method;}
+  const String& url() const {return _url;}
+  String contentType() const {return "application/json";}
+  size_t contentLength() const {return _contentLength;}
+
+  bool hasParam(const String& name, bool post = false) const {return findParam(name, post) != nullptr;}
+  AsyncWebParameter* getParam(const String& name, bool post = false) {return findParam(name, post);}
+
+  void send(AsyncWebServerResponse* response) {delete _response; _response = response;}
+  void send(int code, const String& type = String(), const String& content = String());
+  void send_P(int code, const String& type, const uint8_t* content, size_t len);
+  void send_P(int code, const String& type, PGM_P content) {send_P(code, type, (const uint8_t*)content, strlen(content));}
+  AsyncWebServerResponse* beginChunkedResponse(const String& type, AwsResponseFiller filler);
+
+  //host only
+  void addParam(const String& name, const String& value, bool post) {_params.push_back(AsyncWebParameter(name, value, post));}
+  int responseCode() {return _response ? _response->_code : 0;}
+  //next part of the response body, at most maxLen bytes like a TCP send window. 0 once it is complete
+  size_t readResponse(uint8_t* buffer, size_t maxLen);
+  std::string responseBody(size_t window = 1460); //reads the rest of the body
+
+private:
+  WebRequestMethodComposite _method;
+  String _url;
+  size_t _contentLength;
+  std::vector<AsyncWebParameter> _params;
+  AsyncWebServerResponse* _response = nullptr;
+
+  AsyncWebParameter* findParam(const String& name, bool post) const
+  {
+    for (const AsyncWebParameter& p : _params)
+    {
+      if (p.name() == name && p.isPost() == post) return const_cast<AsyncWebParameter*>(&p);
+    }
+    return nullptr;
+  }
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)> ArBodyHandlerFunction;
+
+class AsyncWebServer {
+public:
+  AsyncWebServer(uint16_t port) : _port(port) {}
+  AsyncWebServer(const AsyncWebServer&) = delete;
+  AsyncWebServer& operator=(const AsyncWebServer&) = delete;
+
+  void begin() {}
+  void end() {}
+  void on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction fn) {_routes.push_back({uri, method, fn});}
+  void onNotFound(ArRequestHandlerFunction fn) {_notFound = fn;}
+  void onRequestBody(ArBodyHandlerFunction fn) {_body = fn;}
+
+  //host only: delivers the body to the body handler in parts of bodyChunk bytes, then runs the request handler.
+  //The caller deletes the request when it has read the response
+  AsyncWebServerRequest* inject(WebRequestMethodComposite method, const char* url, const char* body = "", size_t bodyChunk = 1436);
+  //the same in single steps, so tests can interleave several requests like concurrent TCP connections
+  AsyncWebServerRequest* openRequest(WebRequestMethodComposite method, const char* url, size_t contentLength);
+  void receiveBody(AsyncWebServerRequest* request, const char* data, size_t len, size_t index);
+  void handleRequest(AsyncWebServerRequest* request);
+
+private:
+  struct Route {
+    String uri;
+    WebRequestMethodComposite method;
+    ArRequestHandlerFunction fn;
+  };
+
+  uint16_t _port;
+  std::vector<Route> _routes;
+  ArRequestHandlerFunction _notFound;
+  ArBodyHandlerFunction _body;
+};
+
+#endif
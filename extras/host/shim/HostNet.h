@@ -0,0 +1,10 @@
+#ifndef HostNet_h
+#define HostNet_h
+
+#include <stdint.h>
+
+//host only: ports below 1024 are moved up by ESPALEXA_HOST_PORT_OFFSET (environment, 8000 by default)
+//so nothing needs root, e.g. the web server on port 80 listens on 8080. Other ports are used as they are
+uint16_t hostPort(uint16_t port);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include "Arduino.h"
+
+//IPv4 address, the first octet is the lowest byte like on the ESP
+class IPAddress {
+private:
+  uint8_t _b[4] = {0, 0, 0, 0};
+
+public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {_b[0] = a; _b[1] = b; _b[2] = c; _b[3] = d;}
+  IPAddress(uint32_t v) {memcpy(_b, &v, 4);}
+
+  operator uint32_t() const {uint32_t v; memcpy(&v, _b, 4); return v;}
+  uint8_t operator[](int i) const {return _b[i];}
+  uint8_t& operator[](int i) {return _b[i];}
+  bool operator==(const IPAddress& o) const {return memcmp(_b, o._b, 4) == 0;}
+  bool operator!=(const IPAddress& o) const {return !(*this == o);}
+
+  String toString() const
+  {
+    char s[16];
+    snprintf(s, sizeof(s), "%u.%u.%u.%u", _b[0], _b[1], _b[2], _b[3]);
+    return s;
+  }
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef WString_h
+#define WString_h
+
+//host stand-in for the Arduino String, on top of std::string
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+
+class String {
+private:
+  std::string _s;
+
+  static std::string number(unsigned long v, unsigned char base)
+  {
+    char b[33];
+    int i = sizeof(b) - 1;
+    b[i] = 0;
+    do {b[--i] = "0123456789abcdef"[v % base]; v /= base;} while (v && i);
+    return b + i;
+  }
+
+public:
+  String() {}
+  String(const char* s) : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+  explicit String(char c) : _s(1, c) {}
+  explicit String(unsigned char v, unsigned char base = 10) : _s(number(v, base)) {}
+  explicit String(int v, unsigned char base = 10) : _s(v < 0 && base == 10 ? "-" + number(-(long)v, 10) : number((unsigned)v, base)) {}
+  explicit String(unsigned int v, unsigned char base = 10) : _s(number(v, base)) {}
+  explicit String(long v, unsigned char base = 10) : _s(v < 0 && base == 10 ? "-" + number(-v, 10) : number((unsigned long)v, base)) {}
+  explicit String(unsigned long v, unsigned char base = 10) : _s(number(v, base)) {}
+  explicit String(float v, unsigned char decimals = 2) {char b[48]; snprintf(b, sizeof(b), "%.*f", decimals, v); _s = b;}
+  explicit String(double v, unsigned char decimals = 2) {char b[48]; snprintf(b, sizeof(b), "%.*f", decimals, v); _s = b;}
+
+  const char* c_str() const {return _s.c_str();}
+  unsigned int length() const {return _s.size();}
+  bool reserve(unsigned int size) {_s.reserve(size); return true;}
+  bool isEmpty() const {return _s.empty();}
+
+  String& operator+=(const String& s) {_s += s._s; return *this;}
+  String& operator+=(const char* s) {_s += s; return *this;}
+  String& operator+=(char c) {_s += c; return *this;}
+  bool concat(const String& s) {_s += s._s; return true;}
+
+  bool operator==(const String& s) const {return _s == s._s;}
+  bool operator==(const char* s) const {return _s == s;}
+  bool operator!=(const String& s) const {return _s != s._s;}
+  bool operator!=(const char* s) const {return _s != s;}
+  bool operator<(const String& s) const {return _s < s._s;}
+  bool equals(const String& s) const {return _s == s._s;}
+
+  char charAt(unsigned int i) const {return i < _s.size() ? _s[i] : 0;}
+  char operator[](unsigned int i) const {return charAt(i);}
+
+  int indexOf(char c, unsigned int from = 0) const {size_t p = _s.find(c, from); return p == std::string::npos ? -1 : (int)p;}
+  int indexOf(const char* s, unsigned int from = 0) const {size_t p = _s.find(s, from); return p == std::string::npos ? -1 : (int)p;}
+  int indexOf(const String& s, unsigned int from = 0) const {return indexOf(s.c_str(), from);}
+  int lastIndexOf(char c) const {size_t p = _s.rfind(c); return p == std::string::npos ? -1 : (int)p;}
+  bool startsWith(const String& s) const {return _s.compare(0, s._s.size(), s._s) == 0;}
+  bool endsWith(const String& s) const {return _s.size() >= s._s.size() && _s.compare(_s.size() - s._s.size(), s._s.size(), s._s) == 0;}
+
+  String substring(unsigned int from) const {return from < _s.size() ? String(_s.substr(from)) : String();}
+  String substring(unsigned int from, unsigned int to) const {return from < _s.size() && to > from ? String(_s.substr(from, to - from)) : String();}
+
+  long toInt() const {return atol(_s.c_str());}
+  float toFloat() const {return atof(_s.c_str());}
+
+  void replace(const String& find, const String& with)
+  {
+    if (find._s.empty()) return;
+    for (size_t p = 0; (p = _s.find(find._s, p)) != std::string::npos; p += with._s.size()) _s.replace(p, find._s.size(), with._s);
+  }
+  void toLowerCase() {for (char& c : _s) c = tolower((unsigned char)c);}
+  void toUpperCase() {for (char& c : _s) c = toupper((unsigned char)c);}
+  void trim()
+  {
+    size_t a = _s.find_first_not_of(" \t\r\n"), b = _s.find_last_not_of(" \t\r\n");
+    _s = (a == std::string::npos) ? std::string() : _s.substr(a, b - a + 1);
+  }
+};
+
+inline String operator+(const String& a, const String& b) {String r(a); r += b; return r;}
+inline String operator+(const String& a, const char* b) {String r(a); r += b; return r;}
+inline String operator+(const char* a, const String& b) {String r(a); r += b; return r;}
+inline String operator+(const String& a, char b) {String r(a); r += b; return r;}
+
+#endif
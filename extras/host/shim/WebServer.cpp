@@ -0,0 +1,132 @@
+#include "WebServer.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static HTTPMethod parseMethod(const std::string& m)
+{
+  if (m == "GET") return HTTP_GET;
+  if (m == "HEAD") return HTTP_HEAD;
+  if (m == "POST") return HTTP_POST;
+  if (m == "PUT") return HTTP_PUT;
+  if (m == "PATCH") return HTTP_PATCH;
+  if (m == "DELETE") return HTTP_DELETE;
+  if (m == "OPTIONS") return HTTP_OPTIONS;
+  return HTTP_ANY;
+}
+
+static bool sendAll(int fd, const char* data, size_t len)
+{
+  while (len)
+  {
+    ssize_t n = ::send(fd, data, len, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+void WebServer::begin()
+{
+  close();
+  _fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (_fd < 0) return;
+  int on = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in a;
+  memset(&a, 0, sizeof(a));
+  a.sin_family = AF_INET;
+  a.sin_port = htons(hostPort(_port));
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(_fd, (sockaddr*)&a, sizeof(a)) < 0 || listen(_fd, 8) < 0) {close(); return;}
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+}
+
+void WebServer::close()
+{
+  if (_fd >= 0) ::close(_fd);
+  _fd = -1;
+}
+
+void WebServer::handleClient()
+{
+  if (_fd < 0) return;
+  int client = accept(_fd, nullptr, nullptr);
+  if (client < 0) return;
+  timeval timeout = {2, 0};
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string in;
+  char buf[1024];
+  size_t headerEnd = std::string::npos, contentLength = 0;
+  for (;;)
+  {
+    if (headerEnd == std::string::npos && (headerEnd = in.find("\r\n\r\n")) != std::string::npos)
+    {
+      headerEnd += 4;
+      std::string headers = in.substr(0, headerEnd);
+      for (char& c : headers) c = tolower((unsigned char)c);
+      size_t p = headers.find("\r\ncontent-length:");
+      if (p != std::string::npos) contentLength = strtoul(headers.c_str() + p + 17, nullptr, 10);
+    }
+    if (headerEnd != std::string::npos && in.size() >= headerEnd + contentLength) break;
+    ssize_t n = recv(client, buf, sizeof(buf), 0);
+    if (n <= 0) {::close(client); return;}
+    in.append(buf, n);
+  }
+
+  size_t sp1 = in.find(' '), sp2 = in.find(' ', sp1 + 1);
+  if (sp1 == std::string::npos || sp2 == std::string::npos || sp2 > headerEnd) {::close(client); return;}
+  std::string path = in.substr(sp1 + 1, sp2 - sp1 - 1);
+  size_t query = path.find('?');
+  if (query != std::string::npos) path.resize(query); //uri() has no query, like on the ESP
+  dispatch(parseMethod(in.substr(0, sp1)), path, in.substr(headerEnd, contentLength));
+
+  //a wrong setContentLength() breaks the response like it would on the ESP
+  size_t length = (_contentLength == CONTENT_LENGTH_UNKNOWN) ? _response.size() : _contentLength;
+  char header[256];
+  int len = snprintf(header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+    _code, _code == 200 ? "OK" : "Error", _type.c_str(), length);
+  if (sendAll(client, header, len)) sendAll(client, _response.data(), _response.size());
+  ::close(client);
+}
+
+void WebServer::inject(HTTPMethod method, const char* uri, const char* body)
+{
+  dispatch(method, uri, body);
+}
+
+void WebServer::dispatch(HTTPMethod method, const String& uri, const String& body)
+{
+  _method = method;
+  _uri = uri;
+  _body = body;
+  _code = 0;
+  _type.clear();
+  _response.clear();
+  _contentLength = CONTENT_LENGTH_UNKNOWN;
+  for (const Route& r : _routes)
+  {
+    if (r.uri == uri && (r.method == HTTP_ANY || r.method == method)) {r.fn(); return;}
+  }
+  if (_notFound) _notFound();
+  else send(404, "text/plain", "Not found");
+}
+
+void WebServer::send(int code, const char* type, const String& content)
+{
+  _code = code;
+  _type = type ? type : "text/html";
+  _response.assign(content.c_str(), content.length());
+}
+
+void WebServer::send_P(int code, PGM_P type, PGM_P content, size_t len)
+{
+  _code = code;
+  _type = type;
+  _response.assign(content, len);
+}
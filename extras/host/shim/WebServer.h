@@ -0,0 +1,77 @@
+#ifndef WebServer_h
+#define WebServer_h
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "WiFi.h"
+#include "HostNet.h"
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+
+enum HTTPMethod {HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS};
+
+//the ESP32 WebServer API on a blocking loopback TCP socket, one request per connection.
+//handleClient() answers at most one connection per call, like on the ESP.
+//Tests can also call inject() to run a request without a socket and read the captured response
+class WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  WebServer(int port = 80) : _port(port) {}
+  ~WebServer() {close();}
+  WebServer(const WebServer&) = delete;
+  WebServer& operator=(const WebServer&) = delete;
+
+  void begin();
+  void close();
+  void handleClient();
+
+  void on(const String& uri, THandlerFunction fn) {on(uri, HTTP_ANY, fn);}
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn) {_routes.push_back({uri, method, fn});}
+  void onNotFound(THandlerFunction fn) {_notFound = fn;}
+
+  String uri() {return _uri;}
+  HTTPMethod method() {return _method;}
+  int args() {return _body.length() ? 1 : 0;}
+  String arg(int) {return _body;} //the body is arg 0 ("plain")
+  String arg(const String& name) {return name == "plain" ? _body : String();}
+  bool hasArg(const String& name) {return name == "plain" && _body.length();}
+
+  void send(int code, const char* type = nullptr, const String& content = String());
+  void send(int code, const String& type, const String& content) {send(code, type.c_str(), content);}
+  void send_P(int code, PGM_P type, PGM_P content, size_t len);
+  void setContentLength(size_t len) {_contentLength = len;}
+  void sendContent(const String& content) {sendContent(content.c_str(), content.length());}
+  void sendContent(const char* content, size_t len) {_response.append(content, len);}
+  void sendContent_P(PGM_P content, size_t len) {sendContent(content, len);}
+
+  //host only
+  void inject(HTTPMethod method, const char* uri, const char* body = "");
+  int responseCode() {return _code;}
+  const std::string& responseType() {return _type;}
+  const std::string& responseBody() {return _response;}
+  size_t responseContentLength() {return _contentLength;} //as set by the handler, CONTENT_LENGTH_UNKNOWN if it did not
+  uint16_t localPort() {return hostPort(_port);}
+
+private:
+  struct Route {
+    String uri;
+    HTTPMethod method;
+    THandlerFunction fn;
+  };
+
+  int _port;
+  int _fd = -1;
+  std::vector<Route> _routes;
+  THandlerFunction _notFound;
+  String _uri, _body;
+  HTTPMethod _method = HTTP_GET;
+  int _code = 0;
+  std::string _type, _response;
+  size_t _contentLength = CONTENT_LENGTH_UNKNOWN;
+
+  void dispatch(HTTPMethod method, const String& uri, const String& body);
+};
+
+#endif
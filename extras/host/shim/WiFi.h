@@ -0,0 +1,34 @@
+#ifndef WiFi_h
+#define WiFi_h
+
+#include "IPAddress.h"
+
+typedef enum {WL_IDLE_STATUS = 0, WL_CONNECTED = 3} wl_status_t;
+
+//the host is always "connected", on the loopback interface
+class WiFiClass {
+private:
+  uint8_t _mac[6] = {0x24, 0x0a, 0xc4, 0x12, 0x34, 0x56};
+
+public:
+  wl_status_t begin(const char*, const char* = nullptr) {return WL_CONNECTED;}
+  wl_status_t status() {return WL_CONNECTED;}
+  bool mode(int) {return true;}
+  IPAddress localIP() {return IPAddress(127, 0, 0, 1);}
+
+  String macAddress()
+  {
+    char s[18];
+    snprintf(s, sizeof(s), "%02X:%02X:%02X:%02X:%02X:%02X", _mac[0], _mac[1], _mac[2], _mac[3], _mac[4], _mac[5]);
+    return s;
+  }
+  uint8_t* macAddress(uint8_t* mac) {memcpy(mac, _mac, 6); return mac;}
+
+  //host only
+  void setMacAddress(const uint8_t* mac) {memcpy(_mac, mac, 6);}
+};
+extern WiFiClass WiFi;
+
+#define WIFI_STA 1
+
+#endif
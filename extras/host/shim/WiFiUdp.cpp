@@ -0,0 +1,109 @@
+#include "WiFiUdp.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static sockaddr_in socketAddress(IPAddress ip, uint16_t port)
+{
+  sockaddr_in a;
+  memset(&a, 0, sizeof(a));
+  a.sin_family = AF_INET;
+  a.sin_port = htons(port);
+  a.sin_addr.s_addr = (uint32_t)ip; //IPAddress keeps the first octet in the lowest byte, which is network order here
+  return a;
+}
+
+uint8_t WiFiUDP::open(uint16_t port, IPAddress group)
+{
+  stop();
+  _fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (_fd < 0) return 0;
+  int on = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+  sockaddr_in local = socketAddress(IPAddress(), hostPort(port));
+  if (bind(_fd, (sockaddr*)&local, sizeof(local)) < 0) {stop(); return 0;}
+
+  if ((uint32_t)group != 0)
+  {
+    //best effort, loopback interfaces without multicast still get the unicast requests
+    ip_mreq mreq;
+    mreq.imr_multiaddr.s_addr = (uint32_t)group;
+    mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+    setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_IF, &mreq.imr_interface, sizeof(mreq.imr_interface));
+    setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &on, sizeof(on));
+  }
+  return 1;
+}
+
+void WiFiUDP::stop()
+{
+  if (_fd >= 0) ::close(_fd);
+  _fd = -1;
+  _rxLen = _rxPos = 0;
+}
+
+uint16_t WiFiUDP::localPort()
+{
+  sockaddr_in a;
+  socklen_t len = sizeof(a);
+  if (_fd < 0 || getsockname(_fd, (sockaddr*)&a, &len) < 0) return 0;
+  return ntohs(a.sin_port);
+}
+
+//like on the ESP32 core, there is no new packet until the previous one is dropped by flush() or read to the end byte by byte
+int WiFiUDP::parsePacket()
+{
+  if (_fd < 0 || _rxLen > 0) return 0;
+  sockaddr_in from;
+  socklen_t fromLen = sizeof(from);
+  ssize_t n = recvfrom(_fd, _rx, sizeof(_rx), 0, (sockaddr*)&from, &fromLen);
+  if (n <= 0) return 0;
+  _rxLen = n;
+  _remoteIP = IPAddress((uint32_t)from.sin_addr.s_addr);
+  _remotePort = ntohs(from.sin_port);
+  return n;
+}
+
+int WiFiUDP::read()
+{
+  if (_rxPos < _rxLen) return _rx[_rxPos++];
+  flush();
+  return -1;
+}
+
+int WiFiUDP::read(uint8_t* buffer, size_t len)
+{
+  size_t n = std::min(len, (size_t)(_rxLen - _rxPos));
+  memcpy(buffer, _rx + _rxPos, n);
+  _rxPos += n;
+  return n;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+  _txIP = ip;
+  _txPort = port;
+  _txLen = 0;
+  return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t len)
+{
+  size_t n = std::min(len, sizeof(_tx) - _txLen);
+  memcpy(_tx + _txLen, buffer, n);
+  _txLen += n;
+  return n;
+}
+
+int WiFiUDP::endPacket()
+{
+  if (_fd < 0) _fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in to = socketAddress(_txIP, _txPort);
+  ssize_t n = sendto(_fd, _tx, _txLen, 0, (sockaddr*)&to, sizeof(to));
+  _txLen = 0;
+  return n >= 0;
+}
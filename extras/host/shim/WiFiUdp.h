@@ -0,0 +1,50 @@
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+#include "IPAddress.h"
+#include "HostNet.h"
+
+//UDP on a non-blocking POSIX socket. beginMulticast() joins the group on the loopback interface,
+//so M-SEARCH requests can be sent from the same machine to the group or straight to 127.0.0.1
+class WiFiUDP {
+private:
+  int _fd = -1;
+  uint8_t _rx[1500];
+  int _rxLen = 0, _rxPos = 0;
+  IPAddress _remoteIP;
+  uint16_t _remotePort = 0;
+  uint8_t _tx[1500];
+  size_t _txLen = 0;
+  IPAddress _txIP;
+  uint16_t _txPort = 0;
+
+  uint8_t open(uint16_t port, IPAddress group);
+
+public:
+  WiFiUDP() {}
+  ~WiFiUDP() {stop();}
+  WiFiUDP(const WiFiUDP&) = delete;
+  WiFiUDP& operator=(const WiFiUDP&) = delete;
+
+  uint8_t begin(uint16_t port) {return open(port, IPAddress());}
+  uint8_t beginMulticast(IPAddress group, uint16_t port) {return open(port, group);} //ESP32 core
+  uint8_t beginMulticast(IPAddress, IPAddress group, uint16_t port) {return open(port, group);} //ESP8266 core
+  void stop();
+  uint16_t localPort();
+
+  int parsePacket();
+  int available() {return _rxLen - _rxPos;}
+  int read();
+  int read(uint8_t* buffer, size_t len);
+  int read(char* buffer, size_t len) {return read((uint8_t*)buffer, len);}
+  IPAddress remoteIP() {return _remoteIP;}
+  uint16_t remotePort() {return _remotePort;}
+
+  int beginPacket(IPAddress ip, uint16_t port);
+  size_t write(uint8_t c) {return write(&c, 1);}
+  size_t write(const uint8_t* buffer, size_t len);
+  int endPacket();
+  void flush() {_rxLen = _rxPos = 0;}
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "alloc_count.h"
+#include <atomic>
+#include <stddef.h>
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+
+static std::atomic<long> allocations{0};
+
+long hostAllocations()
+{
+  return allocations;
+}
+
+extern "C" void* malloc(size_t size)
+{
+  allocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t n, size_t size)
+{
+  allocations++;
+  return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* p, size_t size)
+{
+  allocations++;
+  return __libc_realloc(p, size);
+}
@@ -0,0 +1,9 @@
+#ifndef alloc_count_h
+#define alloc_count_h
+
+//counts the heap allocations of the whole program (malloc, calloc, realloc and new), link alloc_count.cpp.
+//Glibc only, and not together with the sanitizers, which replace malloc themselves
+
+long hostAllocations();
+
+#endif
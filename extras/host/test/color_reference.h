@@ -0,0 +1,150 @@
+#ifndef color_reference_h
+#define color_reference_h
+
+//The float conversions getRGB() used before the lookup tables, as reference for the tests and benchmarks.
+//Packed like EspalexaColor: 0xWWRRGGBB
+
+#include <math.h>
+#include <stdint.h>
+
+static inline uint8_t referenceByte(float v)
+{
+  return (uint8_t)(v < 0.1f ? 0.1f : v > 255.1f ? 255.1f : v);
+}
+
+//mired to RGB, https://gist.github.com/paulkaplan/5184275
+static inline uint32_t referenceCt(uint16_t ct)
+{
+  switch (ct) {
+    case 199: return 0xFFFFFFFF;
+    case 234: return 0xFF7F7F7F;
+    case 284: return 0xFF000000;
+    case 350: return 0xFF825A00;
+    case 383: return 0xFFFF9900;
+  }
+  float temp = 10000 / ct; //integer division like before
+  float r, g, b;
+  if (temp <= 66)
+  {
+    r = 255;
+    g = 99.470802 * log(temp) - 161.119568;
+    b = (temp <= 19) ? 0 : 138.517731 * log(temp - 10) - 305.044793;
+  } else {
+    r = 329.698727 * pow(temp - 60, -0.13320476);
+    g = 288.12217 * pow(temp - 60, -0.07551485);
+    b = 255;
+  }
+  return ((uint32_t)referenceByte(r) << 16) | (referenceByte(g) << 8) | referenceByte(b);
+}
+
+static inline float referenceGamma(float v)
+{
+  return v <= 0.0031308f ? 12.92f * v : 1.055f * powf(v, 1.0f / 2.4f) - 0.055f;
+}
+
+static inline uint32_t referenceHs(uint16_t hue, uint8_t sat)
+{
+  float h = hue / 65535.0f, s = sat / 255.0f;
+  uint8_t i = floorf(h * 6);
+  float f = h * 6 - i;
+  float p = 255 * (1 - s), q = 255 * (1 - f * s), t = 255 * (1 - (1 - f) * s);
+  float r, g, b;
+  switch (i % 6) {
+    case 0: r = 255; g = t; b = p; break;
+    case 1: r = q; g = 255; b = p; break;
+    case 2: r = p; g = 255; b = t; break;
+    case 3: r = p; g = q; b = 255; break;
+    case 4: r = t; g = p; b = 255; break;
+    default: r = 255; g = p; b = q;
+  }
+  return ((uint32_t)(uint8_t)r << 16) | ((uint8_t)g << 8) | (uint8_t)b;
+}
+
+//xy to RGB with a XYZ to linear RGB matrix, scaled to the brightest channel. Negative (out of gamut) channels are 0,
+//the old code passed them to pow() and got NaN
+static inline uint32_t referenceXy(float x, float y, const float m[9])
+{
+  float X = x / y, Z = (1.0f - x - y) / y;
+  float c[3];
+  for (int i = 0; i < 3; i++) c[i] = X * m[i*3] + m[i*3+1] + Z * m[i*3+2];
+  float mx = fmaxf(c[0], fmaxf(c[1], c[2]));
+  if (mx <= 0) return 0;
+  uint32_t rgb = 0;
+  for (int i = 0; i < 3; i++) rgb = (rgb << 8) | (uint8_t)(255.0f * referenceGamma(c[i] > 0 ? c[i] / mx : 0));
+  return rgb;
+}
+
+//the Hue wide gamut matrix getRGB() used
+static const float referenceHueWide[9] = {1.656492f, -0.354851f, -0.255038f, -0.707196f, 1.655397f, 0.036152f, 0.051713f, -0.121364f, 1.011530f};
+
+//reference values of the EspalexaGamut profiles: XYZ to linear RGB, linear RGB to XYZ and the primaries (0 if colors are not clamped)
+struct ReferenceGamut {
+  float toRgb[9], toXyz[9], triangle[6];
+};
+
+#define REFERENCE_HUE_WIDE_TO_XYZ {0.664511f, 0.154324f, 0.162028f, 0.283881f, 0.668433f, 0.047685f, 0.000088f, 0.072310f, 0.986039f}
+
+//in EspalexaGamut order: wide, A, B, C (Hue developer documentation) and sRGB (IEC 61966-2-1)
+static const ReferenceGamut referenceGamuts[] = {
+  {{1.656492f, -0.354851f, -0.255038f, -0.707196f, 1.655397f, 0.036152f, 0.051713f, -0.121364f, 1.011530f}, REFERENCE_HUE_WIDE_TO_XYZ, {0, 0, 0, 0, 0, 0}},
+  {{1.656492f, -0.354851f, -0.255038f, -0.707196f, 1.655397f, 0.036152f, 0.051713f, -0.121364f, 1.011530f}, REFERENCE_HUE_WIDE_TO_XYZ, {0.704f, 0.296f, 0.2151f, 0.7106f, 0.138f, 0.08f}},
+  {{1.656492f, -0.354851f, -0.255038f, -0.707196f, 1.655397f, 0.036152f, 0.051713f, -0.121364f, 1.011530f}, REFERENCE_HUE_WIDE_TO_XYZ, {0.675f, 0.322f, 0.409f, 0.518f, 0.167f, 0.04f}},
+  {{1.656492f, -0.354851f, -0.255038f, -0.707196f, 1.655397f, 0.036152f, 0.051713f, -0.121364f, 1.011530f}, REFERENCE_HUE_WIDE_TO_XYZ, {0.692f, 0.308f, 0.17f, 0.7f, 0.153f, 0.048f}},
+  {{3.2406f, -1.5372f, -0.4986f, -0.9689f, 1.8758f, 0.0415f, 0.0557f, -0.2040f, 1.0570f},
+   {0.4124f, 0.3576f, 0.1805f, 0.2126f, 0.7152f, 0.0722f, 0.0193f, 0.1192f, 0.9505f}, {0.64f, 0.33f, 0.30f, 0.60f, 0.15f, 0.06f}},
+};
+
+//moves xy outside of the triangle to the closest point on its border
+static inline void referenceClamp(float& x, float& y, const ReferenceGamut& g)
+{
+  const float* t = g.triangle;
+  if (t[0] == 0) return;
+  bool outside = false;
+  float bestD = 1e9f, bestX = x, bestY = y;
+  for (int e = 0; e < 3; e++)
+  {
+    float ax = t[e*2], ay = t[e*2+1], bx = t[(e*2+2) % 6], by = t[(e*2+3) % 6];
+    if ((bx - ax) * (y - ay) - (by - ay) * (x - ax) >= 0) continue;
+    outside = true;
+    float dx = bx - ax, dy = by - ay;
+    float u = ((x - ax) * dx + (y - ay) * dy) / (dx * dx + dy * dy);
+    u = u < 0 ? 0 : u > 1 ? 1 : u;
+    float cx = ax + u * dx, cy = ay + u * dy;
+    float d = (cx - x) * (cx - x) + (cy - y) * (cy - y);
+    if (d < bestD) {bestD = d; bestX = cx; bestY = cy;}
+  }
+  if (outside) {x = bestX; y = bestY;}
+}
+
+static inline uint32_t referenceGamutXy(float x, float y, const ReferenceGamut& g)
+{
+  referenceClamp(x, y, g);
+  return referenceXy(x, y, g.toRgb);
+}
+
+//RGB to xy like setColor(r, g, b) before, without linearizing the RGB values
+static inline void referenceRgbToXy(uint8_t r, uint8_t g, uint8_t b, float& x, float& y, const ReferenceGamut& p)
+{
+  const float* m = p.toXyz;
+  float X = r * m[0] + g * m[1] + b * m[2];
+  float Y = r * m[3] + g * m[4] + b * m[5];
+  float Z = r * m[6] + g * m[7] + b * m[8];
+  x = X / (X + Y + Z);
+  y = Y / (X + Y + Z);
+  referenceClamp(x, y, p);
+}
+
+//largest difference of the R, G and B bytes
+static inline int channelError(uint32_t a, uint32_t b)
+{
+  int e = 0;
+  for (int s = 0; s <= 16; s += 8)
+  {
+    int d = (int)((a >> s) & 0xFF) - (int)((b >> s) & 0xFF);
+    if (d < 0) d = -d;
+    if (d > e) e = d;
+  }
+  return e;
+}
+
+#endif
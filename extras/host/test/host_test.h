@@ -0,0 +1,95 @@
+#ifndef host_test_h
+#define host_test_h
+
+//minimal checks for the host tests, a test passes if main() returns hostTestResult() without failed checks
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) {printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); hostTestFailures++;} \
+  } while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ != b_) {printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, a_, b_); hostTestFailures++;} \
+  } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) do { \
+    double a_ = (a), b_ = (b); \
+    if (a_ - b_ > (tolerance) || b_ - a_ > (tolerance)) { \
+      printf("%s:%d: CHECK_NEAR(%s, %s) failed: %g and %g differ by more than %g\n", __FILE__, __LINE__, #a, #b, a_, b_, (double)(tolerance)); \
+      hostTestFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_CONTAINS(haystack, needle) do { \
+    std::string h_(haystack); \
+    if (h_.find(needle) == std::string::npos) { \
+      printf("%s:%d: \"%s\" not found in: %s\n", __FILE__, __LINE__, needle, h_.c_str()); hostTestFailures++; \
+    } \
+  } while (0)
+
+//strict enough for the responses Espalexa sends
+static inline bool hostJsonValue(const char*& p)
+{
+  while (*p == ' ') p++;
+  if (*p == '"')
+  {
+    for (p++; *p != '"'; p++)
+    {
+      if (*p == 0 || (unsigned char)*p < 0x20) return false;
+      if (*p == '\\' && (!*++p || !strchr("\"\\/bfnrtu", *p))) return false;
+    }
+    p++;
+    return true;
+  }
+  if (*p == '{' || *p == '[')
+  {
+    char close = (*p == '{') ? '}' : ']';
+    bool object = (close == '}');
+    p++;
+    while (*p == ' ') p++;
+    if (*p == close) {p++; return true;}
+    for (;;)
+    {
+      if (object)
+      {
+        while (*p == ' ') p++;
+        if (*p != '"' || !hostJsonValue(p)) return false;
+        while (*p == ' ') p++;
+        if (*p++ != ':') return false;
+      }
+      if (!hostJsonValue(p)) return false;
+      while (*p == ' ') p++;
+      if (*p == close) {p++; return true;}
+      if (*p++ != ',') return false;
+    }
+  }
+  if (!strncmp(p, "true", 4)) {p += 4; return true;}
+  if (!strncmp(p, "false", 5)) {p += 5; return true;}
+  if (!strncmp(p, "null", 4)) {p += 4; return true;}
+  const char* start = p;
+  if (*p == '-') p++;
+  while ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-') p++;
+  return p > start;
+}
+
+static inline bool hostJsonValid(const std::string& s)
+{
+  const char* p = s.c_str();
+  return hostJsonValue(p) && *p == 0;
+}
+
+static inline int hostTestResult()
+{
+  if (hostTestFailures) printf("%d check(s) failed\n", hostTestFailures);
+  else printf("all checks passed\n");
+  fflush(stdout);
+  return hostTestFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,12 @@
+//a sketch that #defines ESPALEXA_STATIC_DEVICES while the library is built without it. This must not link,
+//see the test layout_mismatch
+
+#define ESPALEXA_STATIC_DEVICES
+#include <Espalexa.h>
+
+Espalexa espalexa;
+
+int main()
+{
+  return espalexa.addDevice("Light", (BrightnessCallbackFunction)nullptr) ? 0 : 1;
+}
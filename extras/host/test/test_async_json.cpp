@@ -0,0 +1,83 @@
+//async chunked JSON responses: every window size gives the same bytes, and devices changing
+//while a response is sent never break it
+
+#include <Espalexa.h>
+#include "host_test.h"
+
+AsyncWebServer server(80);
+Espalexa espalexa;
+EspalexaDevice* lights[50];
+
+static void onChange(EspalexaDevice*) {}
+
+static AsyncWebServerRequest* get(const char* url)
+{
+  return server.inject(HTTP_GET, url);
+}
+
+static std::string read(AsyncWebServerRequest* request, size_t window)
+{
+  std::string body = request->responseBody(window);
+  delete request;
+  return body;
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  server.onNotFound([](AsyncWebServerRequest* request) {
+    if (!espalexa.handleAlexaApiCall(request)) request->send(404, "text/plain", "Not found");
+  });
+  for (int i = 0; i < 50; i++)
+  {
+    lights[i] = new EspalexaDevice("Light " + String(i), onChange, EspalexaDeviceType::extendedcolor, i);
+    espalexa.addDevice(lights[i]);
+  }
+  EspalexaGroup* room = new EspalexaGroup("Everything");
+  for (int i = 0; i < 50; i++) room->addDevice(lights[i]);
+  espalexa.addGroup(room);
+  CHECK(espalexa.begin(&server));
+
+  const char* urls[] = {"/api/u/lights", "/api/u/lights/3", "/api/u/groups", "/api/u/groups/1"};
+  for (const char* url : urls)
+  {
+    std::string whole = read(get(url), 1 << 20);
+    CHECK(hostJsonValid(whole));
+    for (size_t window : {1, 7, 64, 536, 1460}) CHECK(read(get(url), window) == whole);
+  }
+
+  //the first 300 bytes are sent before all lights change, so light 0 is sent as it was and the others as they are now
+  AsyncWebServerRequest* request = get("/api/u/lights");
+  uint8_t first[300];
+  size_t n = request->readResponse(first, sizeof(first));
+  CHECK_EQ(n, sizeof(first));
+  for (int i = 0; i < 50; i++)
+  {
+    lights[i]->setValue(255 - i);
+    lights[i]->setColor(65535, 254);
+    lights[i]->setName("A much longer name for light " + String(i));
+  }
+  std::string body = std::string((const char*)first, n) + read(request, 100);
+  CHECK(hostJsonValid(body));
+  CHECK_CONTAINS(body, "\"name\":\"Light 0\"");
+  CHECK(body.find("\"name\":\"Light 1\"") == std::string::npos);
+  for (int i = 1; i < 50; i++)
+  {
+    std::string name = "\"name\":\"A much longer name for light " + std::to_string(i) + "\"";
+    CHECK_CONTAINS(body, name.c_str());
+  }
+
+  //a group is one part, larger than the part buffer at first. It is sent as it was when its first byte was
+  espalexa.loop(); //publishes the states set above
+  request = get("/api/u/groups");
+  n = request->readResponse(first, 20);
+  for (int i = 0; i < 50; i++) lights[i]->setValue(0);
+  espalexa.loop();
+  body = std::string((const char*)first, n) + read(request, 64);
+  CHECK(hostJsonValid(body));
+  CHECK_CONTAINS(body, "\"state\":{\"all_on\":true,\"any_on\":true}");
+
+  //responses that are never read to the end are freed with the request
+  delete get("/api/u/lights");
+  return hostTestResult();
+}
@@ -0,0 +1,104 @@
+//async request handlers on another thread than loop(), like AsyncTCP on the ESP32. Built with ThreadSanitizer:
+//the handlers only hand their commands over, pending callbacks and transitions are only touched by loop(),
+//and the state in GET responses is read from the snapshots loop() publishes
+
+#include <Espalexa.h>
+#include "host_test.h"
+#include <atomic>
+#include <thread>
+
+AsyncWebServer server(80);
+Espalexa espalexa;
+EspalexaDevice* lights[4];
+static int deviceCalls = 0, groupCalls = 0;
+
+static void onChange(EspalexaDevice*) {deviceCalls++;}
+static void onGroup(EspalexaGroup*) {groupCalls++;}
+
+static void put(const char* url, const char* body)
+{
+  delete server.inject(HTTP_PUT, url, body);
+}
+
+static std::string get(const char* url)
+{
+  AsyncWebServerRequest* r = server.inject(HTTP_GET, url);
+  std::string response = r->responseBody(1460);
+  delete r;
+  return response;
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  server.onNotFound([](AsyncWebServerRequest* request) {
+    if (!espalexa.handleAlexaApiCall(request)) request->send(404, "text/plain", "Not found");
+  });
+  for (int i = 0; i < 4; i++)
+  {
+    lights[i] = new EspalexaDevice("Light " + String(i), onChange, EspalexaDeviceType::extendedcolor);
+    espalexa.addDevice(lights[i]);
+  }
+  EspalexaGroup* room = new EspalexaGroup("Room", onGroup);
+  room->addDevice(lights[2]);
+  room->addDevice(lights[3]);
+  espalexa.addGroup(room);
+  CHECK(espalexa.begin(&server));
+
+  //device commands, some fading, and group commands while loop() runs, each followed by a poll
+  const int commands = 4000;
+  std::atomic<bool> done{false};
+  std::atomic<int> invalid{0};
+  std::thread tcp([&]() {
+    char url[40], body[80];
+    for (int i = 0; i < commands; i++)
+    {
+      if (i % 5 == 4)
+      {
+        snprintf(body, sizeof(body), "{\"bri\":%d,\"hue\":%d}", i % 254, i * 13);
+        put("/api/u/groups/1/action", body);
+        if (!hostJsonValid(get("/api/u/groups"))) invalid++;
+        continue;
+      }
+      snprintf(url, sizeof(url), "/api/u/lights/%d/state", 1 + i % 4);
+      snprintf(body, sizeof(body), "{\"on\":true,\"bri\":%d,\"transitiontime\":%d}", i % 254, (i % 3) ? 0 : 2);
+      put(url, body);
+      if (!hostJsonValid(get(i % 2 ? "/api/u/lights" : "/api/u/lights/1"))) invalid++;
+    }
+    done = true;
+  });
+  while (!done)
+  {
+    espalexa.loop();
+    hostAdvanceMillis(7);
+  }
+  tcp.join();
+  CHECK_EQ(invalid, 0);
+
+  //whatever was not dropped reached the callbacks
+  for (int i = 0; i < 100; i++) {espalexa.loop(); hostAdvanceMillis(10);}
+  EspalexaCallbackStats stats = espalexa.getCallbackStats();
+  CHECK(stats.requested > 0);
+  CHECK(deviceCalls > 0 && groupCalls > 0);
+  CHECK_EQ(stats.requested, stats.delivered + stats.coalesced);
+  CHECK(espalexa.getDroppedCommands() < (uint32_t)commands);
+
+  //commands sent before loop() runs are applied in order by the next loop()
+  put("/api/u/lights/1/state", "{\"on\":true,\"bri\":10}");
+  put("/api/u/lights/1/state", "{\"bri\":20}");
+  put("/api/u/groups/1/action", "{\"on\":true,\"bri\":30}");
+  CHECK(lights[0]->getValue() != 21 || lights[2]->getValue() != 31);
+  espalexa.loop();
+  CHECK_EQ(lights[0]->getValue(), 21);
+  CHECK_EQ(lights[2]->getValue(), 31);
+  CHECK_EQ(lights[3]->getValue(), 31);
+
+  //responses show the state of the last loop(), changes made by the sketch in between appear after the next one
+  CHECK_CONTAINS(get("/api/u/lights/1"), "\"on\":true,\"bri\":20,");
+  CHECK_CONTAINS(get("/api/u/groups/1"), "\"action\":{\"on\":true,\"bri\":30}");
+  lights[0]->setValue(50);
+  CHECK_CONTAINS(get("/api/u/lights/1"), "\"bri\":20,");
+  espalexa.loop();
+  CHECK_CONTAINS(get("/api/u/lights"), "\"on\":true,\"bri\":49,");
+  return hostTestResult();
+}
@@ -0,0 +1,136 @@
+//many async requests in flight at once, their body chunks, handlers and response windows interleaved like
+//concurrent TCP connections on the AsyncTCP task. Every response and every state change belongs to its own request
+
+#include <Espalexa.h>
+#include "host_test.h"
+
+AsyncWebServer server(80);
+Espalexa espalexa;
+EspalexaDevice* lights[8];
+
+static void onChange(EspalexaDevice*) {}
+
+static uint32_t randomState = 12345;
+static uint32_t next(uint32_t n)
+{
+  randomState = randomState * 1103515245 + 12345;
+  return (randomState >> 16) % n;
+}
+
+struct Client {
+  AsyncWebServerRequest* request = nullptr;
+  int kind = 0, light = 0, bri = 0;
+  std::string body, response;
+  size_t sent = 0;
+  bool handled = false;
+};
+
+static int lastBri[8]; //of the last handled PUT per light
+static int completed = 0;
+
+static void start(Client& c, int n)
+{
+  c = Client();
+  c.kind = n % 6;
+  c.light = next(8);
+  char url[48], body[64];
+  snprintf(url, sizeof(url), "/api/u/lights/%d", c.light + 1);
+  const char* u = url;
+  WebRequestMethodComposite method = HTTP_GET;
+  switch (c.kind)
+  {
+    case 0: //state change, with padding so the body arrives in many chunks
+      c.bri = 1 + next(250);
+      snprintf(body, sizeof(body), "{ \"on\" : true , \"bri\" : %d , \"xy\" : [0.3,0.3] }", c.bri - 1);
+      c.body = body;
+      strcat(url, "/state");
+      method = HTTP_PUT;
+      break;
+    case 1: break; //one light
+    case 2: u = "/api/u/lights"; break;
+    case 3: u = "/description.xml"; break;
+    case 4: u = "/espalexa"; break;
+    case 5: u = "/api"; c.body = "{\"devicetype\":\"Echo#" + std::to_string(n) + "\"}"; method = HTTP_POST; break;
+  }
+  c.request = server.openRequest(method, u, c.body.size());
+}
+
+static void check(Client& c)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "\"name\":\"Light %d\"", c.light + 1);
+  switch (c.kind)
+  {
+    case 0: CHECK_CONTAINS(c.response, "success"); break;
+    case 1:
+      CHECK(hostJsonValid(c.response));
+      CHECK_CONTAINS(c.response, name);
+      CHECK(c.response.find("\"name\"") == c.response.rfind("\"name\""));
+      break;
+    case 2:
+      CHECK(hostJsonValid(c.response));
+      CHECK_CONTAINS(c.response, "\"name\":\"Light 8\"");
+      break;
+    case 3: CHECK_CONTAINS(c.response, "<URLBase>http://127.0.0.1:80/</URLBase>"); break;
+    case 4: CHECK_CONTAINS(c.response, "Hello from Espalexa!"); break;
+    case 5: CHECK_CONTAINS(c.response, "\"username\""); break;
+  }
+  completed++;
+}
+
+//one TCP event of the client: a body chunk, the end of the request, or a send window of the response
+static void step(Client& c, int& started)
+{
+  if (c.sent < c.body.size())
+  {
+    size_t n = std::min<size_t>(1 + next(7), c.body.size() - c.sent);
+    server.receiveBody(c.request, c.body.data() + c.sent, n, c.sent);
+    c.sent += n;
+    return;
+  }
+  if (!c.handled)
+  {
+    server.handleRequest(c.request);
+    c.handled = true;
+    if (c.kind == 0) lastBri[c.light] = c.bri;
+    return;
+  }
+  uint8_t window[128];
+  size_t n = c.request->readResponse(window, 1 + next(sizeof(window)));
+  if (n) {c.response.append((const char*)window, n); return;}
+  check(c);
+  delete c.request;
+  start(c, started++);
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  server.onNotFound([](AsyncWebServerRequest* request) {
+    if (!espalexa.handleAlexaApiCall(request)) request->send(404, "text/plain", "Not found");
+  });
+  for (int i = 0; i < 8; i++)
+  {
+    lights[i] = new EspalexaDevice("Light " + String(i + 1), onChange, EspalexaDeviceType::extendedcolor);
+    espalexa.addDevice(lights[i]);
+    lastBri[i] = lights[i]->getValue();
+  }
+  CHECK(espalexa.begin(&server));
+
+  Client clients[12];
+  int started = 0;
+  for (Client& c : clients) start(c, started++);
+  for (int i = 0; i < 200000; i++)
+  {
+    step(clients[next(12)], started);
+    if (i % 8 == 0) espalexa.loop();
+  }
+  for (Client& c : clients) delete c.request;
+  espalexa.loop();
+
+  printf("%d requests completed\n", completed);
+  CHECK(completed > 5000);
+  CHECK_EQ(espalexa.getDroppedCommands(), 0);
+  for (int i = 0; i < 8; i++) CHECK_EQ(lights[i]->getValue(), lastBri[i]);
+  return hostTestResult();
+}
@@ -0,0 +1,58 @@
+//the lookup table conversions of EspalexaColor against the float code getRGB() used before
+
+#include <EspalexaColor.h>
+#include "host_test.h"
+#include "color_reference.h"
+
+int main()
+{
+  //the table holds the old formula for every integer temperature, so ct is exact
+  for (uint32_t ct = EspalexaColor::CT_MIN; ct <= EspalexaColor::CT_MAX; ct++)
+  {
+    CHECK_EQ(EspalexaColor::ct(ct) & 0xFFFFFF, referenceCt(ct) & 0xFFFFFF);
+  }
+  CHECK_EQ(EspalexaColor::ct(100), EspalexaColor::ct(EspalexaColor::CT_MIN));
+  CHECK_EQ(EspalexaColor::ct(1000), EspalexaColor::ct(EspalexaColor::CT_MAX));
+
+  //gamma: at most one level off (float rounding at the level thresholds), and never decreasing
+  int gammaError = 0, gammaOff = 0;
+  uint8_t previous = 0;
+  for (uint32_t v = 0; v <= 65535; v++)
+  {
+    uint8_t level = EspalexaColor::gamma(v);
+    int e = abs((int)level - (int)(uint8_t)(255.0f * referenceGamma(v / 65535.0f)));
+    if (e > gammaError) gammaError = e;
+    if (e) gammaOff++;
+    CHECK(level >= previous);
+    previous = level;
+  }
+  CHECK(gammaError <= 1);
+  CHECK(gammaOff < 10);
+  CHECK_EQ(EspalexaColor::gamma(0), 0);
+  CHECK_EQ(EspalexaColor::gamma(65535), 255);
+
+  int hsError = 0;
+  for (uint32_t hue = 0; hue <= 65535; hue += 97)
+  {
+    for (uint32_t sat = 0; sat <= 255; sat += 5)
+    {
+      int e = channelError(EspalexaColor::hs(hue, sat), referenceHs(hue, sat));
+      if (e > hsError) hsError = e;
+    }
+  }
+  CHECK(hsError <= 1);
+
+  //xy over the whole diagram, the fixed point matrix and gamma table stay within one level
+  int xyError = 0;
+  for (uint32_t x = 0; x <= 65535; x += 655)
+  {
+    for (uint32_t y = 655; x + y <= 65535; y += 655)
+    {
+      int e = channelError(EspalexaColor::xy(x, y), referenceXy(x / 65535.0f, y / 65535.0f, referenceHueWide));
+      if (e > xyError) xyError = e;
+    }
+  }
+  printf("largest errors: gamma %d (%d values), hs %d, xy %d\n", gammaError, gammaOff, hsError, xyError);
+  CHECK(xyError <= 1);
+  return hostTestResult();
+}
@@ -0,0 +1,151 @@
+//ESPALEXA_COMMAND_QUEUE with the network and the devices on different threads, built with ThreadSanitizer:
+//EspalexaQueue and EspalexaSeqlockBuffer on their own, then requests on one thread and processCommands() on another.
+//Built for the async and the sync server
+
+#include <Espalexa.h>
+#include "host_test.h"
+#include <atomic>
+#include <thread>
+
+#ifdef ESPALEXA_ASYNC
+AsyncWebServer server(80);
+typedef WebRequestMethodComposite Method;
+#else
+WebServer server(80);
+typedef HTTPMethod Method;
+#endif
+Espalexa espalexa;
+EspalexaDevice* lights[4];
+static std::atomic<int> calls{0};
+
+static void onChange(EspalexaDevice*) {calls++;}
+
+static std::string request(Method method, const char* url, const char* body = "")
+{
+  #ifdef ESPALEXA_ASYNC
+  AsyncWebServerRequest* r = server.inject(method, url, body);
+  std::string response = r->responseBody(1460);
+  delete r;
+  #else
+  server.inject(method, url, body);
+  std::string response = server.responseBody();
+  //a state published while the response is sent must not break its length
+  size_t length = server.responseContentLength();
+  CHECK(length == CONTENT_LENGTH_UNKNOWN || length == response.size());
+  #endif
+  return response;
+}
+
+static void queueOrder()
+{
+  EspalexaQueue<uint32_t, 8> queue;
+  const uint32_t count = 20000;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < count;)
+    {
+      if (queue.push(i)) i++;
+      else std::this_thread::yield(); //the host may have a single core
+    }
+  });
+  uint32_t expected = 0, v;
+  while (expected < count)
+  {
+    if (!queue.pop(v)) {std::this_thread::yield(); continue;}
+    if (v != expected) break;
+    expected++;
+  }
+  producer.join();
+  CHECK_EQ(expected, count);
+  CHECK(!queue.pop(v));
+}
+
+//every write fills the buffer with one letter, so a torn copy has two
+static void seqlockCopies()
+{
+  EspalexaSeqlockBuffer<64> buffer;
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    char data[64];
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+      size_t len = 1 + i % 64;
+      memset(data, 'a' + i % 26, len);
+      buffer.write(data, len);
+      if (i % 16 == 0) std::this_thread::yield();
+    }
+    done = true;
+  });
+  uint32_t reads = 0, torn = 0;
+  do {
+    char out[64];
+    size_t len = buffer.read(out);
+    for (size_t i = 1; i < len; i++) if (out[i] != out[0]) {torn++; break;}
+    reads++;
+    std::this_thread::yield();
+  } while (!done);
+  writer.join();
+  CHECK_EQ(torn, 0);
+  CHECK(reads > 0);
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  queueOrder();
+  seqlockCopies();
+
+  #ifdef ESPALEXA_ASYNC
+  server.onNotFound([](AsyncWebServerRequest* request) {
+    if (!espalexa.handleAlexaApiCall(request)) request->send(404, "text/plain", "Not found");
+  });
+  #else
+  server.onNotFound([]() {
+    if (!espalexa.handleAlexaApiCall(server.uri(), server.arg(0))) server.send(404, "text/plain", "Not found");
+  });
+  #endif
+  for (int i = 0; i < 4; i++)
+  {
+    lights[i] = new EspalexaDevice("Light " + String(i), onChange, EspalexaDeviceType::extendedcolor, 1);
+    espalexa.addDevice(lights[i]);
+  }
+  EspalexaGroup* room = new EspalexaGroup("Room");
+  room->addDevice(lights[0]);
+  room->addDevice(lights[1]);
+  espalexa.addGroup(room);
+  CHECK(espalexa.begin(&server));
+
+  //the network thread sends commands and reads the state while the application thread applies them
+  std::atomic<bool> done{false};
+  std::thread network([&]() {
+    char url[40], body[64];
+    for (int i = 0; i < 3000; i++)
+    {
+      snprintf(url, sizeof(url), "/api/u/lights/%d/state", 1 + i % 4);
+      snprintf(body, sizeof(body), "{\"on\":true,\"bri\":%d,\"transitiontime\":%d}", i % 254, (i % 7) ? 0 : 1);
+      request(HTTP_PUT, url, body);
+      if (i % 2 == 0) CHECK(hostJsonValid(request(HTTP_GET, "/api/u/lights")));
+      if (i % 50 == 0) CHECK(hostJsonValid(request(HTTP_GET, "/api/u/groups/1")));
+      if (i % 100 == 0) request(HTTP_PUT, "/api/u/groups/1/action", "{\"on\":false}");
+      espalexa.loop();
+      std::this_thread::yield();
+    }
+    done = true;
+  });
+  while (!done)
+  {
+    espalexa.processCommands();
+    hostAdvanceMillis(1);
+    std::this_thread::yield();
+  }
+  network.join();
+  for (int i = 0; i < 200; i++) {espalexa.processCommands(); hostAdvanceMillis(10);}
+  CHECK(calls > 0);
+
+  //the last state is published to the network side
+  request(HTTP_PUT, "/api/u/lights/3/state", "{\"on\":true,\"bri\":99}");
+  CHECK(request(HTTP_GET, "/api/u/lights/3").find("\"bri\":99") == std::string::npos);
+  espalexa.processCommands();
+  CHECK_CONTAINS(request(HTTP_GET, "/api/u/lights/3"), "\"on\":true,\"bri\":99,");
+  printf("%u commands dropped\n", espalexa.getDroppedCommands());
+  return hostTestResult();
+}
@@ -0,0 +1,64 @@
+//getRGB() converts once per color change, however many channels are read. Built with ESPALEXA_DEBUG for getConversionCount()
+
+#include <Espalexa.h>
+#include "host_test.h"
+
+WebServer server(80);
+Espalexa espalexa;
+EspalexaDevice* light;
+
+static void onChange(EspalexaDevice*) {}
+
+//conversions done while reading every channel twice
+static uint32_t readAll()
+{
+  uint32_t before = EspalexaDevice::getConversionCount();
+  for (int i = 0; i < 2; i++)
+  {
+    light->getR(); light->getG(); light->getB(); light->getW(); light->getRGB();
+  }
+  return EspalexaDevice::getConversionCount() - before;
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  server.onNotFound([]() {espalexa.handleAlexaApiCall(server.uri(), server.arg(0));});
+  light = new EspalexaDevice("Light", onChange, EspalexaDeviceType::extendedcolor, 255);
+  espalexa.addDevice(light);
+  CHECK(espalexa.begin(&server));
+  readAll();
+
+  //284 is black RGB with full white, 0 used to mean "not converted yet"
+  light->setColor((uint16_t)284);
+  CHECK_EQ(readAll(), 1);
+  CHECK_EQ(light->getRGB(), 0xFF000000);
+  CHECK_EQ(readAll(), 0);
+
+  light->setColor((uint16_t)383);
+  CHECK_EQ(readAll(), 1);
+  light->setColor(21845, 254);
+  CHECK_EQ(readAll(), 1);
+  light->setColorXY(0.675, 0.322);
+  CHECK_EQ(readAll(), 1);
+  light->setGamut(EspalexaGamut::C);
+  CHECK_EQ(readAll(), 1);
+
+  //brightness doesn't change the color, RGB set by the sketch (black too) is kept as it is
+  light->setValue(10);
+  CHECK_EQ(readAll(), 0);
+  light->setColor((uint8_t)0, 0, 0);
+  CHECK_EQ(readAll(), 0);
+  CHECK_EQ(light->getRGB(), 0);
+
+  //the same through the Hue API, with the JSON state render in between
+  server.inject(HTTP_PUT, "/api/u/lights/1/state", "{\"ct\":284}");
+  espalexa.loop();
+  server.inject(HTTP_GET, "/api/u/lights/1");
+  CHECK_EQ(readAll(), 1);
+  CHECK_EQ(light->getRGB(), 0xFF000000);
+  server.inject(HTTP_PUT, "/api/u/lights/1/state", "{\"hue\":1000,\"sat\":200}");
+  espalexa.loop();
+  CHECK_EQ(readAll(), 1);
+  return hostTestResult();
+}
@@ -0,0 +1,53 @@
+//device names: kept whole in a String by default, with ESPALEXA_STATIC_DEVICES cut to 32 characters (the Hue limit)
+//and ESPALEXA_DEVICE_NAME_LEN bytes without splitting a UTF-8 character
+
+#include <Espalexa.h>
+#include "host_test.h"
+
+WebServer server(80);
+Espalexa espalexa;
+
+static void onChange(EspalexaDevice*) {}
+
+static std::string repeat(const char* s, int n)
+{
+  std::string r;
+  while (n--) r += s;
+  return r;
+}
+
+static std::string stored(const std::string& name)
+{
+  EspalexaDevice d(name.c_str(), onChange);
+  return d.getNameCStr();
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  std::string ascii = repeat("a", 40), umlauts = repeat("\xC3\xBC", 40), mixed = repeat("K\xC3\xBC", 20); //ü is 2 bytes
+  #ifdef ESPALEXA_STATIC_DEVICES
+  CHECK(stored(ascii) == repeat("a", 32));
+  #if ESPALEXA_DEVICE_NAME_LEN >= 64
+  CHECK(stored(umlauts) == repeat("\xC3\xBC", 32));
+  CHECK(stored(mixed) == repeat("K\xC3\xBC", 16));
+  #else
+  CHECK(stored(umlauts) == repeat("\xC3\xBC", ESPALEXA_DEVICE_NAME_LEN / 2));
+  CHECK(stored(repeat("\xE2\x82\xAC", 11)) == repeat("\xE2\x82\xAC", 10)); //the 11th 3 byte character would end at byte 33
+  #endif
+  #else
+  CHECK(stored(ascii) == ascii);
+  CHECK(stored(umlauts) == umlauts);
+  CHECK(stored(mixed) == mixed);
+  #endif
+  CHECK(stored("Kitchen") == "Kitchen");
+
+  //the light listing has the stored names
+  server.onNotFound([]() {espalexa.handleAlexaApiCall(server.uri(), server.arg(0));});
+  espalexa.addDevice(mixed.c_str(), onChange, EspalexaDeviceType::dimmable);
+  CHECK(espalexa.begin(&server));
+  server.inject(HTTP_GET, "/api/u/lights/1");
+  CHECK(hostJsonValid(server.responseBody()));
+  CHECK_CONTAINS(server.responseBody(), ("\"name\":\"" + stored(mixed) + "\"").c_str());
+  return hostTestResult();
+}
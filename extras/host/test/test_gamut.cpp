@@ -0,0 +1,87 @@
+//the EspalexaGamut profiles against float conversions with the reference matrices and primaries of each gamut
+
+#include <EspalexaDevice.h>
+#include "host_test.h"
+#include "color_reference.h"
+
+static const EspalexaGamut gamuts[] = {EspalexaGamut::wide, EspalexaGamut::A, EspalexaGamut::B, EspalexaGamut::C, EspalexaGamut::srgb};
+static const char* names[] = {"wide", "A", "B", "C", "srgb"};
+
+//is xy inside (or on) the triangle, with a tolerance of about one fixed point step
+static bool inside(float x, float y, const ReferenceGamut& g)
+{
+  const float* t = g.triangle;
+  for (int e = 0; e < 3; e++)
+  {
+    float ax = t[e*2], ay = t[e*2+1], bx = t[(e*2+2) % 6], by = t[(e*2+3) % 6];
+    float side = ((bx - ax) * (y - ay) - (by - ay) * (x - ax)) / sqrtf((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+    if (side < -0.00005f) return false;
+  }
+  return true;
+}
+
+int main()
+{
+  for (int i = 0; i < 5; i++)
+  {
+    EspalexaGamut gamut = gamuts[i];
+    const ReferenceGamut& ref = referenceGamuts[i];
+
+    //xy to RGB over the whole diagram, including the colors that are moved to the border of the gamut
+    int xyError = 0;
+    for (uint32_t x = 0; x <= 65535; x += 655)
+    {
+      for (uint32_t y = 655; x + y <= 65535; y += 655)
+      {
+        int e = channelError(EspalexaColor::xy(x, y, gamut), referenceGamutXy(x / 65535.0f, y / 65535.0f, ref));
+        if (e > xyError) xyError = e;
+      }
+    }
+
+    //RGB to xy, the result is always inside the gamut
+    float xyDiff = 0;
+    for (uint32_t c = 1; c < (1 << 24); c += 9973)
+    {
+      uint8_t r = c >> 16, g = c >> 8, b = c;
+      uint16_t x, y;
+      CHECK(EspalexaColor::rgbToXy(r, g, b, x, y, gamut));
+      float rx, ry;
+      referenceRgbToXy(r, g, b, rx, ry, ref);
+      xyDiff = fmaxf(xyDiff, fmaxf(fabsf(x / 65535.0f - rx), fabsf(y / 65535.0f - ry)));
+      if (ref.triangle[0] != 0) CHECK(inside(x / 65535.0f, y / 65535.0f, ref));
+    }
+    printf("gamut %s: largest xy to RGB error %d, RGB to xy error %.5f\n", names[i], xyError, xyDiff);
+    CHECK(xyError <= 1);
+    CHECK(xyDiff < 0.0002f);
+
+    //the primaries of a clamped gamut give full single channels
+    if (ref.triangle[0] != 0)
+    {
+      uint32_t primary[3];
+      for (int p = 0; p < 3; p++) primary[p] = EspalexaColor::xy(ref.triangle[p*2] * 65535 + 0.5f, ref.triangle[p*2+1] * 65535 + 0.5f, gamut);
+      for (int p = 0; p < 3; p++) CHECK(channelError(primary[p], referenceGamutXy(ref.triangle[p*2], ref.triangle[p*2+1], ref)) <= 1);
+    }
+
+    //a device uses the gamut for both directions
+    EspalexaDevice d("Light", (DeviceCallbackFunction)nullptr, EspalexaDeviceType::color);
+    d.setGamut(gamut);
+    d.setColor(255, 0, 0);
+    float rx, ry;
+    referenceRgbToXy(255, 0, 0, rx, ry, ref);
+    CHECK_NEAR(d.getX(), rx, 0.0002);
+    CHECK_NEAR(d.getY(), ry, 0.0002);
+    CHECK_EQ(d.getRGB(), 0xFF0000); //the RGB it was set to
+    d.setColorXY(0.72f, 0.27f); //outside of every gamut
+    CHECK(channelError(d.getRGB(), referenceGamutXy(0.72f, 0.27f, ref)) <= 1);
+  }
+
+  //sRGB white is D65 and goes back to white
+  uint16_t x, y;
+  CHECK(EspalexaColor::rgbToXy(255, 255, 255, x, y, EspalexaGamut::srgb));
+  CHECK_NEAR(x / 65535.0, 0.3127, 0.0005);
+  CHECK_NEAR(y / 65535.0, 0.3290, 0.0005);
+  CHECK(channelError(EspalexaColor::xy(x, y, EspalexaGamut::srgb), 0xFFFFFF) <= 1);
+  //black has no chromaticity
+  CHECK(!EspalexaColor::rgbToXy(0, 0, 0, x, y, EspalexaGamut::C));
+  return hostTestResult();
+}
@@ -0,0 +1,91 @@
+//Hue groups: one command for all devices, one group callback, and the changed properties of every device
+
+#include <Espalexa.h>
+#include "host_test.h"
+#include <type_traits>
+
+static_assert(!std::is_copy_constructible<EspalexaGroup>::value && !std::is_copy_assignable<EspalexaGroup>::value,
+  "Espalexa keeps pointers to groups, they must not be copied");
+
+WebServer server(80);
+Espalexa espalexa;
+EspalexaDevice* lights[4];
+static int groupCalls = 0, deviceCalls = 0;
+
+static void onGroup(EspalexaGroup*) {groupCalls++;}
+static void onDevice(EspalexaDevice*) {deviceCalls++;}
+
+static uint8_t bits(std::initializer_list<EspalexaDeviceProperty> props)
+{
+  uint8_t b = 0;
+  for (EspalexaDeviceProperty p : props) b |= 1 << static_cast<uint8_t>(p);
+  return b;
+}
+
+static void put(const char* uri, const char* body)
+{
+  server.inject(HTTP_PUT, uri, body);
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  server.onNotFound([]() {espalexa.handleAlexaApiCall(server.uri(), server.arg(0));});
+  for (int i = 0; i < 4; i++)
+  {
+    lights[i] = new EspalexaDevice("Light " + String(i + 1), onDevice, EspalexaDeviceType::extendedcolor);
+    espalexa.addDevice(lights[i]);
+  }
+  EspalexaGroup room("Room", onGroup);
+  for (int i = 0; i < 3; i++) CHECK(room.addDevice(lights[i]));
+  CHECK(!room.addDevice(lights[0])); //only once
+  CHECK(!room.addDevice(nullptr));
+  EspalexaGroup hall("Hall"); //no callback, the device callbacks are called
+  hall.addDevice(lights[3]);
+  CHECK(espalexa.addGroup(&room));
+  CHECK(espalexa.addGroup(&hall));
+  CHECK(!espalexa.addGroup(nullptr));
+  EspalexaGroup full("Full");
+  for (int i = 0; i < ESPALEXA_MAXDEVICES; i++) CHECK(full.addDevice(new EspalexaDevice("Extra", onDevice)));
+  CHECK_EQ(full.getDeviceCount(), ESPALEXA_MAXDEVICES);
+  CHECK(!full.addDevice(lights[0]));
+  for (int i = 0; i < ESPALEXA_MAXDEVICES; i++) delete full.getDevice(i);
+  CHECK(espalexa.begin(&server));
+
+  put("/api/u/groups/1/action", "{\"on\":true,\"xy\":[0.3,0.3]}");
+  espalexa.loop();
+  CHECK_EQ(groupCalls, 1);
+  CHECK_EQ(deviceCalls, 0);
+  for (int i = 0; i < 3; i++) CHECK_EQ(lights[i]->getChangedProperties(), bits({EspalexaDeviceProperty::on, EspalexaDeviceProperty::xy}));
+
+  //the next command after the callback starts over for every device of the group, not only the first
+  put("/api/u/groups/1/action", "{\"on\":false}");
+  espalexa.loop();
+  CHECK_EQ(groupCalls, 2);
+  for (int i = 0; i < 3; i++) CHECK_EQ(lights[i]->getChangedProperties(), bits({EspalexaDeviceProperty::off}));
+
+  //commands before the callback ran are merged into it
+  put("/api/u/groups/1/action", "{\"on\":true,\"bri\":100}");
+  put("/api/u/groups/1/action", "{\"ct\":300}");
+  espalexa.loop();
+  CHECK_EQ(groupCalls, 3);
+  for (int i = 0; i < 3; i++)
+  {
+    CHECK_EQ(lights[i]->getChangedProperties(), bits({EspalexaDeviceProperty::on, EspalexaDeviceProperty::bri, EspalexaDeviceProperty::ct}));
+    CHECK_EQ(lights[i]->getValue(), 101);
+    CHECK_EQ(lights[i]->getCt(), 300);
+  }
+  CHECK_EQ(lights[3]->getValue(), 0);
+
+  //a group without callback calls the device callbacks
+  put("/api/u/groups/2/action", "{\"on\":true,\"hue\":1000,\"sat\":100}");
+  espalexa.loop();
+  CHECK_EQ(deviceCalls, 1);
+  CHECK_EQ(lights[3]->getChangedProperties(), bits({EspalexaDeviceProperty::on, EspalexaDeviceProperty::hs}));
+
+  server.inject(HTTP_GET, "/api/u/groups/1");
+  CHECK(hostJsonValid(server.responseBody()));
+  CHECK_CONTAINS(server.responseBody(), "\"name\":\"Room\"");
+  CHECK_CONTAINS(server.responseBody(), "\"state\":{\"all_on\":true,\"any_on\":true}");
+  return hostTestResult();
+}
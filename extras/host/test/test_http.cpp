@@ -0,0 +1,95 @@
+//sync web server on a loopback socket: discovery page, Hue API and the status page
+
+#include <Espalexa.h>
+#include "host_test.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+Espalexa espalexa;
+static int calls = 0;
+static uint8_t lastValue = 0;
+
+static void onChange(uint8_t value)
+{
+  calls++;
+  lastValue = value;
+}
+
+static void onColor(uint8_t, uint32_t) {}
+
+//the request is buffered by the kernel until loop() accepts the connection, so no client thread is needed
+static std::string request(const char* method, const char* path, const char* body = "")
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a;
+  memset(&a, 0, sizeof(a));
+  a.sin_family = AF_INET;
+  a.sin_port = htons(hostPort(80));
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr*)&a, sizeof(a)) < 0) {close(fd); return "<no connection>";}
+  char head[256];
+  int len = snprintf(head, sizeof(head), "%s %s HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/x-www-form-urlencoded\r\nContent-Length: %zu\r\n\r\n",
+    method, path, strlen(body));
+  send(fd, head, len, 0);
+  send(fd, body, strlen(body), 0);
+  espalexa.loop();
+
+  std::string response;
+  char buf[1024];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) response.append(buf, n);
+  close(fd);
+  return response;
+}
+
+static std::string body(const std::string& response)
+{
+  size_t p = response.find("\r\n\r\n");
+  return p == std::string::npos ? std::string() : response.substr(p + 4);
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  espalexa.addDevice("Kitchen", onChange, 0);
+  espalexa.addDevice("Hall \"light\"", onColor, 127);
+  CHECK(espalexa.begin());
+
+  std::string r = request("GET", "/description.xml");
+  CHECK_CONTAINS(r, "HTTP/1.1 200");
+  CHECK_CONTAINS(r, "<URLBase>http://127.0.0.1:80/</URLBase>");
+  CHECK_CONTAINS(r, "<serialNumber>240ac4123456</serialNumber>");
+
+  r = request("POST", "/api", "{\"devicetype\":\"Echo\"}");
+  CHECK_CONTAINS(r, "\"username\"");
+
+  r = request("GET", "/api/user/lights");
+  std::string lights = body(r);
+  char length[40];
+  snprintf(length, sizeof(length), "Content-Length: %zu\r\n", lights.size());
+  CHECK_CONTAINS(r, length);
+  CHECK(lights.front() == '{' && lights.back() == '}');
+  CHECK_CONTAINS(lights, "\"name\":\"Kitchen\"");
+  CHECK_CONTAINS(lights, "\"name\":\"Hall \\\"light\\\"\"");
+  CHECK_CONTAINS(lights, "\"state\":{\"on\":false,\"bri\":254,");
+  CHECK_CONTAINS(lights, "\"state\":{\"on\":true,\"bri\":126,\"hue\":0,\"sat\":0,\"effect\":\"none\",\"xy\":[0.50,0.50],\"ct\":500");
+
+  r = request("PUT", "/api/user/lights/1/state", "{\"on\":true,\"bri\":100}");
+  CHECK_CONTAINS(body(r), "success");
+  espalexa.loop();
+  CHECK_EQ(calls, 1);
+  CHECK_EQ(lastValue, 101);
+
+  r = request("GET", "/api/user/lights/1");
+  CHECK_CONTAINS(body(r), "{\"state\":{\"on\":true,\"bri\":100,");
+
+  r = request("GET", "/espalexa");
+  CHECK_CONTAINS(r, "Hello from Espalexa!");
+  CHECK_CONTAINS(r, "Value of device 1 (Kitchen): 101");
+
+  r = request("GET", "/nothing/here");
+  CHECK_CONTAINS(r, "HTTP/1.1 404");
+  return hostTestResult();
+}
@@ -0,0 +1,71 @@
+//several client threads on loopback sockets at once against the sync web server, while the main thread runs loop()
+
+#include <Espalexa.h>
+#include "host_test.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+Espalexa espalexa;
+
+static void onChange(EspalexaDevice*) {}
+
+static std::string request(const char* method, const char* path, const std::string& body)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a;
+  memset(&a, 0, sizeof(a));
+  a.sin_family = AF_INET;
+  a.sin_port = htons(hostPort(80));
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr*)&a, sizeof(a)) < 0) {close(fd); return "<no connection>";}
+  char head[256];
+  int len = snprintf(head, sizeof(head), "%s %s HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: %zu\r\n\r\n", method, path, body.size());
+  std::string out = std::string(head, len) + body;
+  for (size_t i = 0; i < out.size(); i += 5) send(fd, out.data() + i, std::min<size_t>(5, out.size() - i), 0); //small TCP segments
+  std::string response;
+  char buf[512];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) response.append(buf, n);
+  close(fd);
+  return response;
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  for (int i = 0; i < 6; i++) espalexa.addDevice("Light " + String(i + 1), onChange, EspalexaDeviceType::extendedcolor);
+  CHECK(espalexa.begin());
+
+  //each thread only changes and reads its own light, so it always knows what it has to get back
+  std::atomic<int> running{6}, failures{0};
+  std::vector<std::thread> clients;
+  for (int t = 0; t < 6; t++)
+  {
+    clients.emplace_back([t, &running, &failures]() {
+      char path[48], body[48], expected[64];
+      for (int i = 0; i < 60; i++)
+      {
+        int bri = (t * 37 + i * 11) % 254;
+        snprintf(path, sizeof(path), "/api/u/lights/%d/state", t + 1);
+        snprintf(body, sizeof(body), "{\"on\":true,\"bri\":%d}", bri);
+        if (request("PUT", path, body).find("success") == std::string::npos) failures++;
+        snprintf(path, sizeof(path), "/api/u/lights/%d", t + 1);
+        snprintf(expected, sizeof(expected), "{\"state\":{\"on\":true,\"bri\":%d,", bri);
+        std::string r = request("GET", path, "");
+        size_t p = r.find("\r\n\r\n");
+        if (p == std::string::npos || !hostJsonValid(r.substr(p + 4)) || r.find(expected) == std::string::npos) failures++;
+        snprintf(expected, sizeof(expected), "\"name\":\"Light %d\"", t + 1);
+        if (r.find(expected) == std::string::npos || r.find("\"name\"") != r.rfind("\"name\"")) failures++;
+      }
+      running--;
+    });
+  }
+  while (running) espalexa.loop();
+  for (std::thread& c : clients) c.join();
+  CHECK_EQ(failures, 0);
+  return hostTestResult();
+}
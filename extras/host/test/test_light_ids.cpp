@@ -0,0 +1,59 @@
+//light IDs of 255 devices: unique, stable, and each one leads back to its device
+
+#include <Espalexa.h>
+#include "host_test.h"
+#include <set>
+
+WebServer server(80);
+Espalexa espalexa;
+
+static void onChange(uint8_t) {}
+
+static std::string get(const std::string& url)
+{
+  server.inject(HTTP_GET, url.c_str());
+  return server.responseBody();
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  server.onNotFound([]() {espalexa.handleAlexaApiCall(server.uri(), server.arg(0));});
+  for (int i = 0; i < 255; i++) CHECK(espalexa.addDevice("d" + String(i), onChange, (uint8_t)i));
+  CHECK(!espalexa.addDevice("one too many", onChange, 0));
+  CHECK(espalexa.begin(&server));
+
+  std::string lights = get("/api/u/lights");
+  CHECK(hostJsonValid(lights));
+  std::set<uint32_t> ids;
+  size_t p = 0;
+  for (int i = 0; (p = lights.find("\"uniqueid\":\"", p)) != std::string::npos; i++)
+  {
+    p += 12;
+    std::string id = lights.substr(p, lights.find('"', p) - p);
+    uint32_t v = strtoul(id.c_str(), nullptr, 10);
+    ids.insert(v);
+    CHECK(espalexa.getDeviceByLightId(v) == espalexa.getDevice(i));
+    std::string name = "\"name\":\"d" + std::to_string(i) + "\"";
+    CHECK_CONTAINS(get("/api/u/lights/" + id), name.c_str());
+    CHECK_CONTAINS(get("/api/u/lights/" + std::to_string(i+1)), name.c_str()); //plain light numbers work as well
+    if (i < 15) CHECK_EQ(v, 0x1234560u + i + 1); //Tasmota IDs: MAC bytes 4-6 and the index
+    else CHECK((v >> 28) == 1 && (v & 0xFFF) == (uint32_t)i + 1);
+  }
+  CHECK_EQ(ids.size(), 255);
+
+  //nothing for IDs of devices that don't exist
+  CHECK(get("/api/u/lights/256") == "{}");
+  CHECK(espalexa.getDeviceByLightId(0) == nullptr);
+  CHECK(espalexa.getDeviceByLightId((1UL << 28) | 300) == nullptr);
+
+  //the same MAC and order give the same IDs after a restart
+  Espalexa restarted;
+  for (int i = 0; i < 255; i++) restarted.addDevice("d" + String(i), onChange, (uint8_t)i);
+  WebServer other(80);
+  other.onNotFound([&]() {restarted.handleAlexaApiCall(other.uri(), other.arg(0));});
+  restarted.begin(&other);
+  other.inject(HTTP_GET, "/api/u/lights");
+  CHECK(other.responseBody() == lights);
+  return hostTestResult();
+}
@@ -0,0 +1,76 @@
+//ESPALEXA_STATIC_DEVICES: once begin() has run, managing the devices never touches the heap.
+//Counts every malloc of the program, so the web server stand-in is left out and commands go through EspalexaTestHooks
+
+#define ESPALEXA_TEST_HOOKS
+#include <Espalexa.h>
+#include <EspalexaTestHooks.h>
+#include "alloc_count.h"
+#include "host_test.h"
+
+WebServer server(80);
+Espalexa espalexa;
+EspalexaGroup room("Room");
+static int calls = 0;
+
+static void onChange(EspalexaDevice*) {calls++;}
+static void onBrightness(uint8_t) {calls++;}
+static void discard(void*, const char*, size_t) {}
+
+static EspalexaCommand command(const char* body)
+{
+  EspalexaCommand cmd;
+  cmd.parse(body, strlen(body));
+  return cmd;
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  long before = hostAllocations();
+  for (int i = 0; i < ESPALEXA_MAXDEVICES - 1; i++) CHECK(espalexa.addDevice("Light", onChange, EspalexaDeviceType::extendedcolor));
+  CHECK(espalexa.addDevice("Dimmer", onBrightness, 10));
+  CHECK_EQ(hostAllocations() - before, 0); //the names fit the small string buffer of the host String, on the ESP they would be copied into the pool
+  CHECK(!espalexa.addDevice("One too many", onBrightness));
+  for (int i = 0; i < ESPALEXA_MAXDEVICES; i++) room.addDevice(espalexa.getDevice(i));
+  espalexa.addGroup(&room);
+  CHECK(espalexa.begin(&server));
+  espalexa.setCallbackDebounce(50);
+
+  const char* bodies[] = {
+    "{\"on\":true,\"bri\":200}", "{\"xy\":[0.675,0.322]}", "{\"hue\":40000,\"sat\":200,\"transitiontime\":5}",
+    "{\"ct\":300}", "{\"on\":false,\"transitiontime\":2}", "{\"on\":true}"
+  };
+  EspalexaUpdate updates[2];
+  updates[0].device = espalexa.getDevice(0);
+  updates[0].cmd.setOn(true);
+  updates[1].device = espalexa.getDevice(1);
+  updates[1].cmd.setOn(false);
+  char chunk[256];
+
+  before = hostAllocations();
+  for (int round = 0; round < 50; round++)
+  {
+    EspalexaCommand cmd = command(bodies[round % 6]);
+    EspalexaTestHooks::applyCommand(espalexa, espalexa.getDevice(round % ESPALEXA_MAXDEVICES), cmd);
+    if (round % 5 == 0) EspalexaTestHooks::applyGroupCommand(espalexa, &room, cmd);
+    if (round % 7 == 0) espalexa.applyBatch(updates, 2, true);
+    for (int i = 0; i < 20; i++)
+    {
+      hostAdvanceMillis(10);
+      espalexa.loop(); //fades and callbacks
+    }
+    for (int i = 0; i < ESPALEXA_MAXDEVICES; i++)
+    {
+      EspalexaDevice* d = espalexa.getDevice(i);
+      d->getRGB();
+      d->setValue(round);
+      d->setColor(255, round, 0);
+    }
+    EspalexaJsonWriter json(chunk, sizeof(chunk), discard, nullptr);
+    EspalexaTestHooks::renderLights(espalexa, json, ESPALEXA_MAXDEVICES);
+    json.flush();
+  }
+  CHECK_EQ(hostAllocations() - before, 0);
+  CHECK(calls > 0);
+  return hostTestResult();
+}
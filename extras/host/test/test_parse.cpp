@@ -0,0 +1,87 @@
+//Hue state bodies, parsed with EspalexaCommand
+
+#include <EspalexaCommand.h>
+#include "host_test.h"
+
+static EspalexaCommand parse(const char* body, bool ok = true)
+{
+  EspalexaCommand cmd;
+  CHECK(cmd.parse(body, strlen(body)) == ok);
+  return cmd;
+}
+
+static uint8_t bits(std::initializer_list<EspalexaCommandField> fields)
+{
+  uint8_t b = 0;
+  for (EspalexaCommandField f : fields) b |= static_cast<uint8_t>(f);
+  return b;
+}
+
+int main()
+{
+  EspalexaCommand c = parse("{\"on\":true}");
+  CHECK_EQ(c.fields, bits({EspalexaCommandField::on}));
+  CHECK(c.on);
+
+  c = parse(" {\n\"on\" : false ,\"bri\": 254 }");
+  CHECK_EQ(c.fields, bits({EspalexaCommandField::on, EspalexaCommandField::bri}));
+  CHECK(!c.on);
+  CHECK_EQ(c.bri, 254);
+
+  c = parse("{\"hue\":65535,\"sat\":254,\"transitiontime\":4}");
+  CHECK_EQ(c.fields, bits({EspalexaCommandField::hue, EspalexaCommandField::sat, EspalexaCommandField::transitiontime}));
+  CHECK_EQ(c.hue, 65535);
+  CHECK_EQ(c.sat, 254);
+  CHECK_EQ(c.transitiontime, 4);
+
+  //both coordinates, whatever their digits look like
+  c = parse("{\"xy\":[0.3127,0.0329]}");
+  CHECK_EQ(c.fields, bits({EspalexaCommandField::xy}));
+  CHECK_EQ(c.x, 20493); //0.3127 * 65535
+  CHECK_EQ(c.y, 2156);
+  c = parse("{\"xy\":[ 1 , 0.5e-1 ]}"); //exponents are ignored
+  CHECK_EQ(c.x, 65535);
+  CHECK_EQ(c.y, 32768);
+  c = parse("{\"xy\":[0.675,0.322]}");
+  CHECK_EQ(c.x, 44236);
+  CHECK_EQ(c.y, 21102);
+  //every 4 digit coordinate, n * 65535 overflowed 32 bits from 0.6554 up
+  for (uint32_t n = 0; n <= 10000; n++)
+  {
+    char body[40];
+    snprintf(body, sizeof(body), "{\"xy\":[%u.%04u,0.%04u]}", n / 10000, n % 10000, 9999 - n % 10000);
+    c = parse(body);
+    CHECK_EQ(c.x, (n * 65535 + 5000) / 10000);
+    CHECK_EQ(c.y, ((9999 - n % 10000) * 65535 + 5000) / 10000);
+  }
+
+  //keys only match as a whole, unknown values of any kind are skipped
+  c = parse("{\"effect\":\"ct\",\"alert\":{\"a\":[1,2,\"x]\"],\"ct\":1},\"colormode\":\"xy\",\"ct\":383}");
+  CHECK_EQ(c.fields, bits({EspalexaCommandField::ct}));
+  CHECK_EQ(c.ct, 383);
+  c = parse("{\"name\":\"a\\\"b,\\\"bri\\\":1\",\"bri\":5}");
+  CHECK_EQ(c.fields, bits({EspalexaCommandField::bri}));
+  CHECK_EQ(c.bri, 5);
+
+  //out of range values are clamped
+  c = parse("{\"bri\":300,\"sat\":-3,\"ct\":99999}");
+  CHECK_EQ(c.bri, 255);
+  CHECK_EQ(c.sat, 0);
+  CHECK_EQ(c.ct, 65535);
+
+  //fields before a syntax error are kept
+  c = parse("{\"on\":true,\"bri\":12", false);
+  CHECK_EQ(c.fields, bits({EspalexaCommandField::on, EspalexaCommandField::bri}));
+  c = parse("{\"on\":yes}", false);
+  CHECK_EQ(c.fields, 0);
+  parse("", false);
+  parse("[1]", false);
+  CHECK_EQ(parse("{}").fields, 0);
+
+  //the length is respected, the body doesn't have to be terminated
+  const char* body = "{\"bri\":100}{\"bri\":200}";
+  CHECK(c.parse(body, 11));
+  CHECK_EQ(c.bri, 100);
+  CHECK(!c.parse(body, 7));
+  return hostTestResult();
+}
@@ -0,0 +1,108 @@
+//SSDP discovery over real UDP on the loopback interface
+
+#include <Espalexa.h>
+#include "host_test.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+Espalexa espalexa;
+
+static void onChange(uint8_t) {}
+
+static int client()
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  timeval timeout = {0, 200000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return fd;
+}
+
+static bool search(int fd, const char* to, const char* st, int mx)
+{
+  char packet[256];
+  int len = snprintf(packet, sizeof(packet), "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: %d\r\nST: %s\r\n\r\n", mx, st);
+  sockaddr_in a;
+  memset(&a, 0, sizeof(a));
+  a.sin_family = AF_INET;
+  a.sin_port = htons(1900);
+  inet_pton(AF_INET, to, &a.sin_addr);
+  return sendto(fd, packet, len, 0, (sockaddr*)&a, sizeof(a)) == len;
+}
+
+static std::string reply(int fd)
+{
+  char buf[1024];
+  ssize_t n = recv(fd, buf, sizeof(buf), 0);
+  return n > 0 ? std::string(buf, n) : std::string();
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  espalexa.addDevice("Kitchen", onChange, 0);
+  CHECK(espalexa.begin());
+  int fd = client();
+
+  //MX 0 is answered right away
+  CHECK(search(fd, "127.0.0.1", "urn:schemas-upnp-org:device:basic:1", 0));
+  espalexa.loop();
+  std::string r = reply(fd);
+  CHECK_CONTAINS(r, "HTTP/1.1 200 OK\r\n");
+  CHECK_CONTAINS(r, "LOCATION: http://127.0.0.1:80/description.xml\r\n");
+  CHECK_CONTAINS(r, "hue-bridgeid: 240ac4123456\r\n");
+
+  //other device types are not answered
+  CHECK(search(fd, "127.0.0.1", "urn:dial-multiscreen-org:service:dial:1", 0));
+  espalexa.loop();
+  CHECK(reply(fd).empty());
+
+  //a reply is due at a random time within the MX window, a repeated search shares it
+  CHECK(search(fd, "127.0.0.1", "ssdp:all", 2));
+  CHECK(search(fd, "127.0.0.1", "upnp:rootdevice", 2));
+  int replies = 0;
+  for (int ms = 0; ms <= 2000; ms += 100)
+  {
+    espalexa.loop();
+    hostAdvanceMillis(100);
+  }
+  while (!reply(fd).empty()) replies++;
+  CHECK_EQ(replies, 1);
+  EspalexaSsdpStats stats = espalexa.getSsdpStats();
+  CHECK_EQ(stats.searches, 3);
+  CHECK_EQ(stats.coalesced, 1);
+  CHECK_EQ(stats.replies, 2);
+
+  //a packet longer than the buffer and the searches queued behind it are all drained by one loop()
+  hostAdvanceMillis(3000);
+  std::string junk(ESPALEXA_UDP_BUFFER + 100, 'x');
+  sockaddr_in self;
+  memset(&self, 0, sizeof(self));
+  self.sin_family = AF_INET;
+  self.sin_port = htons(1900);
+  inet_pton(AF_INET, "127.0.0.1", &self.sin_addr);
+  CHECK(sendto(fd, junk.data(), junk.size(), 0, (sockaddr*)&self, sizeof(self)) == (ssize_t)junk.size());
+  CHECK(search(fd, "127.0.0.1", "ssdp:all", 0));
+  int other = client();
+  CHECK(search(other, "127.0.0.1", "ssdp:all", 0));
+  usleep(10000);
+  espalexa.loop();
+  CHECK_CONTAINS(reply(fd), "HTTP/1.1 200 OK\r\n");
+  CHECK_CONTAINS(reply(other), "HTTP/1.1 200 OK\r\n");
+  CHECK_EQ(espalexa.getSsdpStats().searches, 5);
+  close(other);
+
+  //the multicast group only works if the loopback interface supports multicast
+  hostAdvanceMillis(3000);
+  if (search(fd, "239.255.255.250", "ssdp:all", 0))
+  {
+    espalexa.loop();
+    r = reply(fd);
+    if (r.empty()) printf("no multicast on the loopback interface, skipped\n");
+    else CHECK_CONTAINS(r, "LOCATION: http://127.0.0.1:80/description.xml\r\n");
+  }
+  close(fd);
+  return hostTestResult();
+}
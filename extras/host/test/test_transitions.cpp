@@ -0,0 +1,120 @@
+//Hue transitiontime fades: one frame per 1000 / ESPALEXA_TRANSITION_FPS ms, exact end points,
+//the shortest way around the color wheel, and commands replacing a running fade
+
+#include <Espalexa.h>
+#include "host_test.h"
+#include <vector>
+
+WebServer server(80);
+Espalexa espalexa;
+EspalexaDevice* light;
+
+struct Frame {
+  unsigned long ms;
+  uint8_t value;
+  uint16_t hue, ct;
+};
+static std::vector<Frame> frames;
+
+static void onChange(EspalexaDevice* d)
+{
+  frames.push_back({millis(), d->getValue(), d->getHue(), d->getCt()});
+}
+
+static void put(const char* body)
+{
+  server.inject(HTTP_PUT, "/api/u/lights/1/state", body);
+}
+
+//runs loop() every ms
+static void run(unsigned long ms)
+{
+  for (unsigned long i = 0; i < ms; i++)
+  {
+    hostAdvanceMillis(1);
+    espalexa.loop();
+  }
+}
+
+int main()
+{
+  hostSetMillis(1000);
+  server.onNotFound([]() {espalexa.handleAlexaApiCall(server.uri(), server.arg(0));});
+  light = new EspalexaDevice("Light", onChange, EspalexaDeviceType::extendedcolor, 1);
+  espalexa.addDevice(light);
+  CHECK(espalexa.begin(&server));
+  const unsigned long frameTime = 1000 / ESPALEXA_TRANSITION_FPS;
+
+  //brightness 1 to 254 in one second
+  unsigned long start = millis();
+  put("{\"on\":true,\"bri\":253,\"transitiontime\":10}");
+  CHECK_EQ(light->getValue(), 1); //starts where it was
+  run(1500);
+  CHECK_EQ(frames.size(), 1000 / frameTime);
+  for (size_t i = 0; i < frames.size(); i++)
+  {
+    unsigned long elapsed = frames[i].ms - start;
+    CHECK_EQ(elapsed, (i + 1) * frameTime);
+    CHECK_NEAR(frames[i].value, 1 + 253.0 * elapsed / 1000, 1);
+    if (i) CHECK(frames[i].value >= frames[i-1].value);
+  }
+  CHECK_EQ(frames.back().ms - start, 1000);
+  CHECK_EQ(frames.back().value, 254);
+  CHECK_EQ(light->getValue(), 254);
+
+  //fading out ends at 0, the next ON restores the brightness from before
+  frames.clear();
+  put("{\"on\":false,\"transitiontime\":4}");
+  run(600);
+  CHECK_EQ(frames.size(), 400 / frameTime);
+  CHECK_EQ(frames.back().value, 0);
+  put("{\"on\":true}");
+  run(10);
+  CHECK_EQ(light->getValue(), 254);
+
+  //hue from 60000 to 5000 goes up through 65535, not down through the middle of the wheel, and back down again
+  put("{\"hue\":60000,\"sat\":254}");
+  run(10);
+  for (uint16_t to : {5000, 60000})
+  {
+    frames.clear();
+    uint16_t from = light->getHue();
+    char body[64];
+    snprintf(body, sizeof(body), "{\"hue\":%u,\"transitiontime\":10}", to);
+    put(body);
+    run(1500);
+    CHECK_EQ(frames.size(), 1000 / frameTime);
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+      uint16_t hue = frames[i].hue;
+      CHECK(hue >= 60000 || hue <= 5000);
+      uint16_t travelled = (to == 5000) ? (uint16_t)(hue - from) : (uint16_t)(from - hue);
+      CHECK_NEAR(travelled, 10535.0 * (i + 1) / frames.size(), 8);
+    }
+    CHECK_EQ(frames.back().hue, to);
+    CHECK_EQ(light->getHue(), to);
+    CHECK_EQ(light->getSat(), 254);
+  }
+
+  //color temperature ends exactly at the target too, with the first frame after the end if the time is no multiple of the frame time
+  put("{\"ct\":153}");
+  run(10);
+  frames.clear();
+  start = millis();
+  put("{\"ct\":500,\"transitiontime\":3}");
+  run(500);
+  CHECK_EQ(frames.size(), (300 + frameTime - 1) / frameTime);
+  CHECK(frames.back().ms - start >= 300 && frames.back().ms - start < 300 + frameTime);
+  CHECK_EQ(frames.back().ct, 500);
+
+  //a new command stops the running fade
+  frames.clear();
+  put("{\"bri\":0,\"transitiontime\":10}");
+  run(500);
+  CHECK(light->getValue() > 100 && light->getValue() < 160);
+  put("{\"bri\":49}");
+  run(1000);
+  CHECK_EQ(light->getValue(), 50);
+  CHECK_EQ(frames.back().value, 50);
+  return hostTestResult();
+}
@@ -27,7 +27,101 @@
 #ifndef ESPALEXA_MAXDEVICES
  #define ESPALEXA_MAXDEVICES 10 //this limit only has memory reasons, set it higher should you need to
 #endif
+#if ESPALEXA_MAXDEVICES > 255
+ #error "ESPALEXA_MAXDEVICES can be at most 255"
+#endif
+
+//rooms or zones served through the Hue /groups API, see addGroup()
+#ifndef ESPALEXA_MAXGROUPS
+ #define ESPALEXA_MAXGROUPS 4
+#endif
+#if ESPALEXA_MAXGROUPS > 255
+ #error "ESPALEXA_MAXGROUPS can be at most 255"
+#endif
+
+//size of the stack buffer JSON responses are streamed through
+#ifndef ESPALEXA_JSON_CHUNK
+ #define ESPALEXA_JSON_CHUNK 256
+#endif
+
+//disables the per-device cache of rendered state JSON (saves ESPALEXA_STATE_CACHE bytes of RAM per device slot). Not with ESPALEXA_ASYNC
+//or ESPALEXA_COMMAND_QUEUE, the web server reads the device states from the cache there
+//#define ESPALEXA_NO_JSON_CACHE
+
+#ifndef ESPALEXA_STATE_CACHE
+ #define ESPALEXA_STATE_CACHE 176 //max. 255
+#endif
+
+//M-SEARCH replies are sent at a random time within the MX window of the request (capped to ESPALEXA_SSDP_MAX_MX seconds)
+#ifndef ESPALEXA_SSDP_MAX_MX
+ #define ESPALEXA_SSDP_MAX_MX 5
+#endif
+#ifndef ESPALEXA_SSDP_QUEUE
+ #define ESPALEXA_SSDP_QUEUE 8 //requesters tracked at the same time
+#endif
+#ifndef ESPALEXA_SSDP_REPLIES_PER_SEC
+ #define ESPALEXA_SSDP_REPLIES_PER_SEC 10
+#endif
+
+//loop() reads up to ESPALEXA_UDP_PACKET_BUDGET pending UDP packets, stopping early after ESPALEXA_UDP_TIME_BUDGET microseconds
+#ifndef ESPALEXA_UDP_PACKET_BUDGET
+ #define ESPALEXA_UDP_PACKET_BUDGET 8
+#endif
+#ifndef ESPALEXA_UDP_TIME_BUDGET
+ #define ESPALEXA_UDP_TIME_BUDGET 2000
+#endif
+#ifndef ESPALEXA_UDP_BUFFER
+ #define ESPALEXA_UDP_BUFFER 512
+#endif
+
+//Alexa commands are queued (up to ESPALEXA_COMMAND_QUEUE, a power of two) and applied by processCommands() instead of loop(),
+//so the network and the devices can be handled by different tasks. Add all devices before begin(). Needs <atomic> (ESP32)
+//#define ESPALEXA_COMMAND_QUEUE 16
+#ifdef ESPALEXA_COMMAND_QUEUE
+ #define ESPALEXA_COMMAND_HANDOFF ESPALEXA_COMMAND_QUEUE
+#elif defined ESPALEXA_ASYNC
+ //async request handlers run on the TCP task, so they hand their commands to loop() through a queue of this size (a power of two)
+ #ifndef ESPALEXA_ASYNC_COMMANDS
+  #define ESPALEXA_ASYNC_COMMANDS 16
+ #endif
+ #define ESPALEXA_COMMAND_HANDOFF ESPALEXA_ASYNC_COMMANDS
+#endif
+
+//if the web server runs on another task than the devices, it only reads state snapshots published by that task
+#ifdef ESPALEXA_COMMAND_HANDOFF
+ #define ESPALEXA_STATE_SNAPSHOTS
+ #ifdef ESPALEXA_NO_JSON_CACHE
+  #error "ESPALEXA_ASYNC and ESPALEXA_COMMAND_QUEUE need the JSON cache"
+ #endif
+ #if ESPALEXA_STATE_CACHE < 176
+  #error "ESPALEXA_ASYNC and ESPALEXA_COMMAND_QUEUE need an ESPALEXA_STATE_CACHE of at least 176"
+ #endif
+#endif
+
+//device callbacks of Alexa commands run from loop(), at most once per ESPALEXA_CALLBACK_DEBOUNCE ms and device.
+//Commands arriving in the meantime are merged into the pending callback
+#ifndef ESPALEXA_CALLBACK_DEBOUNCE
+ #define ESPALEXA_CALLBACK_DEBOUNCE 0
+#endif
+
+//Hue transitiontime fades are interpolated in loop() at this frame rate, calling the device callback once per frame
+#ifndef ESPALEXA_TRANSITION_FPS
+ #define ESPALEXA_TRANSITION_FPS 25
+#endif
+//ignores transitiontime and applies every change instantly
+//#define ESPALEXA_NO_TRANSITIONS
+
+//devices added by name are kept in a pool inside Espalexa instead of being allocated, with their names stored in the device
+//(see EspalexaDevice.h). It changes EspalexaDevice, so it has to be a global build flag (e.g. build_flags = -D ESPALEXA_STATIC_DEVICES),
+//like ESPALEXA_DEVICE_NAME_LEN, not a #define in the sketch
+//#define ESPALEXA_STATIC_DEVICES
+
+//request bodies larger than this are ignored in async mode (Hue state changes are much smaller)
+#ifndef ESPALEXA_MAX_BODY
+ #define ESPALEXA_MAX_BODY 1024
+#endif
 
+//prints debug output. The color conversion count on the status page also needs it as a global build flag, so EspalexaDevice.cpp sees it
 //#define ESPALEXA_DEBUG
 
 #ifdef ESPALEXA_ASYNC
@@ -37,6 +131,7 @@
   #include <ESPAsyncTCP.h>
  #endif
  #include <ESPAsyncWebServer.h>
+ #include <memory>
 #else
  #ifdef ARDUINO_ARCH_ESP32
   #include <WiFi.h>
@@ -58,46 +153,165 @@
 #endif
 
 #include "EspalexaDevice.h"
+#include "EspalexaGroup.h"
+#include "EspalexaColor.h"
+#include "EspalexaJson.h"
+#include "EspalexaCommand.h"
+#ifdef ESPALEXA_COMMAND_HANDOFF
+#include "EspalexaQueue.h"
+#endif
+
+//SSDP discovery counters, see Espalexa::getSsdpStats()
+struct EspalexaSsdpStats {
+  uint32_t searches = 0;  //M-SEARCH requests Espalexa should answer
+  uint32_t replies = 0;   //replies sent
+  uint32_t coalesced = 0; //repeated searches answered by an already scheduled reply
+  uint32_t dropped = 0;   //searches not answered because the queue or the reply budget was exhausted
+};
+
+#ifdef ESPALEXA_ASYNC
+typedef AsyncWebServerRequest EspalexaHttp;
+#elif defined ARDUINO_ARCH_ESP32
+typedef WebServer EspalexaHttp;
+#else
+typedef ESP8266WebServer EspalexaHttp;
+#endif
+
+//one HTTP request being answered. It is passed to the handlers instead of being kept in Espalexa,
+//so requests that are in flight at the same time on the async server can't answer with each other's data
+struct EspalexaRequest {
+  EspalexaHttp* http; //the response is sent here
+  const char* body;   //zero terminated, "" if there is none
+  size_t len;
+};
+
+//state change of one device for Espalexa::applyBatch()
+struct EspalexaUpdate {
+  EspalexaDevice* device;
+  EspalexaCommand cmd; //see EspalexaCommand::setOn() and the following
+};
+
+//device callback counters, see Espalexa::getCallbackStats()
+struct EspalexaCallbackStats {
+  uint32_t requested = 0; //device changes by Alexa
+  uint32_t coalesced = 0; //changes merged into an already pending callback
+  uint32_t delivered = 0; //callbacks run
+};
 
 
 class Espalexa {
+  #ifdef ESPALEXA_TEST_HOOKS
+  friend struct EspalexaTestHooks; //see EspalexaTestHooks.h
+  #endif
 private:
   //private member vars
   #ifdef ESPALEXA_ASYNC
   AsyncWebServer* serverAsync;
-  AsyncWebServerRequest* server; //this saves many #defines
-  String body = "";
-  #elif defined ARDUINO_ARCH_ESP32
-  WebServer* server;
   #else
-  ESP8266WebServer* server;
+  EspalexaHttp* server;
   #endif
   uint8_t currentDeviceCount = 0;
   bool discoverable = true;
 
   EspalexaDevice* devices[ESPALEXA_MAXDEVICES] = {};
   //Keep in mind that Device IDs go from 1 to DEVICES, cpp arrays from 0 to DEVICES-1!!
+  #ifdef ESPALEXA_STATIC_DEVICES
+  EspalexaDevice devicePool[ESPALEXA_MAXDEVICES]; //devices added by name
+  #else
+  bool ownedDevices[ESPALEXA_MAXDEVICES] = {}; //added by name, so deleted with Espalexa
+  #endif
+  EspalexaGroup* groups[ESPALEXA_MAXGROUPS] = {}; //same for group IDs
+  uint8_t currentGroupCount = 0;
   
   WiFiUDP espalexaUdp;
   IPAddress ipMulti;
   bool udpConnected = false;
-  char packetBuffer[255]; //buffer to hold incoming udp packet
+  char packetBuffer[ESPALEXA_UDP_BUFFER]; //buffer to hold incoming udp packet
+  uint8_t udpPacketBudget = ESPALEXA_UDP_PACKET_BUDGET;
+  uint32_t udpTimeBudget = ESPALEXA_UDP_TIME_BUDGET;
   String escapedMac=""; //lowercase mac address
+  uint32_t lightIdBase = 0; //MAC part of the light IDs, set in begin()
+  
+  //discovery payloads, see renderDiscovery()
+  char descriptionXml[800];
+  char searchResponse[320];
+  uint16_t descriptionXmlLen = 0, searchResponseLen = 0;
+  IPAddress discoveryIP;
+  bool discoveryRendered = false;
+  
+  struct SearchReply {
+    IPAddress ip;
+    uint16_t port = 0;
+    bool pending = false;
+    uint32_t due = 0;   //when to send the reply
+    uint32_t until = 0; //end of the requester's MX window
+  };
+  SearchReply searchReplies[ESPALEXA_SSDP_QUEUE];
+  EspalexaSsdpStats ssdpStats;
+  uint32_t replyBudgetStart = 0;
+  uint8_t replyBudgetUsed = 0;
+
+  //deferred callbacks, see triggerCallback()
+  uint8_t pendingCallbacks[ESPALEXA_MAXDEVICES]; //slots of the devices with a pending callback
+  uint8_t pendingCallbackCount = 0;
+  uint32_t callbackDue[ESPALEXA_MAXDEVICES] = {}; //0 if no callback is pending
+  uint32_t callbackDebounce = ESPALEXA_CALLBACK_DEBOUNCE;
+  EspalexaCallbackStats callbackStats;
+  uint32_t groupCallbackDue[ESPALEXA_MAXGROUPS] = {}; //0 if no group callback is pending
+  uint8_t pendingGroupCallbackCount = 0;
+
+  #ifndef ESPALEXA_NO_TRANSITIONS
+  struct Transition {
+    uint32_t start = 0;    //millis() when the transition was started
+    uint32_t duration = 0; //in ms
+    uint16_t fromColor[2], toColor[2]; //ct, hue and sat or x and y, depending on mode
+    uint8_t fromBri = 0, toBri = 0;
+    EspalexaColorMode mode = EspalexaColorMode::none; //none if only brightness is faded
+    uint8_t group = 0; //group ID if the frames call the group callback instead of the device callback
+    bool notify = true; //false if the frames call no device callback
+  };
+  Transition transitions[ESPALEXA_MAXDEVICES];
+  uint8_t activeTransitions[ESPALEXA_MAXDEVICES]; //slots of the devices mid-transition
+  uint8_t activeTransitionCount = 0;
+  uint32_t lastFrame = 0;
+  #endif
+
+  #ifdef ESPALEXA_COMMAND_HANDOFF
+  struct QueuedCommand {
+    uint8_t slot;
+    uint8_t group = 0; //group ID if the command is for a group instead of the device in slot
+    EspalexaCommand cmd;
+  };
+  EspalexaQueue<QueuedCommand, ESPALEXA_COMMAND_HANDOFF> commandQueue; //network to application side
+  std::atomic<uint32_t> droppedCommands{0};
+  #endif
+
+  #ifdef ESPALEXA_STATE_SNAPSHOTS
+  //state objects rendered by the application side, the network side only reads these
+  EspalexaSeqlockBuffer<ESPALEXA_STATE_CACHE> stateSnapshot[ESPALEXA_MAXDEVICES];
+  uint16_t stateSnapshotVersion[ESPALEXA_MAXDEVICES] = {};
+  std::atomic<uint8_t> stateSnapshotValue[ESPALEXA_MAXDEVICES]; //for the group states
+  #elif !defined ESPALEXA_NO_JSON_CACHE
+  //pre-rendered state objects of each device, valid while the device version matches
+  char stateCache[ESPALEXA_MAXDEVICES][ESPALEXA_STATE_CACHE];
+  uint8_t stateCacheLen[ESPALEXA_MAXDEVICES] = {};
+  uint16_t stateCacheVersion[ESPALEXA_MAXDEVICES] = {};
+  #endif
   
   //private member functions
-  String boolString(bool st)
+  const char* boolString(bool st)
   {
     return(st)?"true":"false";
   }
   
-  String modeString(EspalexaColorMode m)
+  const char* modeString(EspalexaColorMode m)
   {
     if (m == EspalexaColorMode::xy) return "xy";
     if (m == EspalexaColorMode::hs) return "hs";
     return "ct";
   }
   
-  String typeString(EspalexaDeviceType t)
+  const char* typeString(EspalexaDeviceType t)
   {
     switch (t)
     {
@@ -105,11 +319,12 @@ private:
       case EspalexaDeviceType::whitespectrum: return "Color temperature light";
       case EspalexaDeviceType::color:         return "Color light";
       case EspalexaDeviceType::extendedcolor: return "Extended color light";
+      default: break;
     }
     return "Light";
   }
   
-  String modelidString(EspalexaDeviceType t)
+  const char* modelidString(EspalexaDeviceType t)
   {
     switch (t)
     {
@@ -117,152 +332,866 @@ private:
       case EspalexaDeviceType::whitespectrum: return "LWT010";
       case EspalexaDeviceType::color:         return "LST001";
       case EspalexaDeviceType::extendedcolor: return "LCT015";
+      default: break;
     }
     return "Plug";
   }
   
   //Workaround functions courtesy of Sonoff-Tasmota
+  //The first 15 devices keep the original Tasmota IDs, so existing Alexa pairings stay valid.
+  //Devices 16 and up get IDs with bit 28 set and a 12 bit index. Both only depend on the MAC and the order of addDevice() calls.
   uint32_t encodeLightId(uint8_t idx)
   {
-    uint8_t mac[6];
-    WiFi.macAddress(mac);
-    uint32_t id = (mac[3] << 20) | (mac[4] << 12) | (mac[5] << 4) | (idx & 0xF);
-    return id;
+    if (idx < 16) return lightIdBase | idx;
+    return (1UL << 28) | ((lightIdBase & 0xFFFF0) << 8) | idx;
   }
 
+  //device number (1-based) for a light ID, a uniqueid or a plain device number
   uint32_t decodeLightId(uint32_t id) {
+    if (id <= ESPALEXA_MAXDEVICES) return id;
+    if (id & (1UL << 28)) return id & 0xFFF;
     return id & 0xF;
   }
   
-  //device JSON string: color+temperature device emulates LCT015, dimmable device LWB010, (TODO: on/off Plug 01, color temperature device LWT010, color device LST001)
-  String deviceJsonString(uint8_t deviceId)
+  //device state JSON object, only depends on the device fields covered by getVersion()
+  void deviceStateJson(EspalexaJsonWriter& json, EspalexaDevice* dev)
   {
-    deviceId--;
-    if (deviceId >= currentDeviceCount) return "{}"; //error
-    EspalexaDevice* dev = devices[deviceId];
-
-    String json = "{\"state\":{\"on\":";
-    json += boolString(dev->getValue());
+    json.print("{\"on\":");
+    json.print(boolString(dev->getValue()));
     if (dev->getType() != EspalexaDeviceType::onoff) //bri support
     {
-      json += ",\"bri\":" + String(dev->getLastValue()-1);
+      json.print(",\"bri\":"); json.print((uint32_t)dev->getLastValue()-1);
       if (static_cast<uint8_t>(dev->getType()) > 2) //color support
       {
-        json += ",\"hue\":" + String(dev->getHue()) + ",\"sat\":" + String(dev->getSat());
-        json += ",\"effect\":\"none\",\"xy\":[" + String(dev->getX()) + "," + String(dev->getY()) + "]";
+        json.print(",\"hue\":"); json.print((uint32_t)dev->getHue());
+        json.print(",\"sat\":"); json.print((uint32_t)dev->getSat());
+        json.print(",\"effect\":\"none\",\"xy\":["); json.printFixed(dev->getXFixed(), 2);
+        json.write(','); json.printFixed(dev->getYFixed(), 2); json.write(']');
       }
       if (static_cast<uint8_t>(dev->getType()) > 1 && dev->getType() != EspalexaDeviceType::color) //white spectrum support
       {
-        json += ",\"ct\":" + String(dev->getCt());
+        json.print(",\"ct\":"); json.print((uint32_t)dev->getCt());
+      }
+    }
+    json.print(",\"alert\":\"none");
+    if (static_cast<uint8_t>(dev->getType()) > 1) {json.print("\",\"colormode\":\""); json.print(modeString(dev->getColorMode()));}
+    json.print("\",\"mode\":\"homeautomation\",\"reachable\":true}");
+  }
+
+  //device JSON: color+temperature device emulates LCT015, dimmable device LWB010, (TODO: on/off Plug 01, color temperature device LWT010, color device LST001)
+  void deviceJson(EspalexaJsonWriter& json, uint8_t deviceId)
+  {
+    deviceId--;
+    if (deviceId >= currentDeviceCount) {json.print("{}"); return;} //error
+    EspalexaDevice* dev = devices[deviceId];
+
+    json.print("{\"state\":");
+    #ifdef ESPALEXA_STATE_SNAPSHOTS
+    char state[ESPALEXA_STATE_CACHE];
+    json.write(state, stateSnapshot[deviceId].read(state)); //the device may be changed by another task right now
+    #elif defined ESPALEXA_NO_JSON_CACHE
+    deviceStateJson(json, dev);
+    #else
+    //re-render the state fragment only if the device changed since the last poll
+    uint16_t version = dev->getVersion();
+    if (stateCacheLen[deviceId] == 0 || stateCacheVersion[deviceId] != version)
+    {
+      EspalexaJsonWriter cache(stateCache[deviceId], ESPALEXA_STATE_CACHE);
+      deviceStateJson(cache, dev);
+      stateCacheLen[deviceId] = (cache.total() <= ESPALEXA_STATE_CACHE) ? cache.total() : 0;
+      stateCacheVersion[deviceId] = version; //read before rendering, a change in between renders it again next time
+    }
+    if (stateCacheLen[deviceId] == 0) deviceStateJson(json, dev); //too long to cache
+    else json.write(stateCache[deviceId], stateCacheLen[deviceId]);
+    #endif
+    json.print(",\"type\":\""); json.print(typeString(dev->getType()));
+    json.print("\",\"name\":\""); json.printEscaped(dev->getNameCStr());
+    json.print("\",\"modelid\":\""); json.print(modelidString(dev->getType()));
+    json.print("\",\"manufacturername\":\"Philips\",\"productname\":\"E"); json.print((uint32_t)static_cast<uint8_t>(dev->getType()));
+    json.print("\",\"uniqueid\":\""); json.print(encodeLightId(deviceId+1));
+    json.print("\",\"swversion\":\"espalexa-2.4.4\"}");
+  }
+
+  //all lights JSON object, keyed by light ID. Part n is the n-th light, the last part closes the object
+  bool lightsJson(EspalexaJsonWriter& json, uint8_t, uint32_t part)
+  {
+    if (part > currentDeviceCount) return false;
+    if (part == 0) json.write('{');
+    if (part == currentDeviceCount) {json.write('}'); return true;}
+    if (part > 0) json.write(',');
+    json.write('"'); json.print(encodeLightId(part+1)); json.print("\":");
+    deviceJson(json, part+1);
+    return true;
+  }
+
+  bool lightJson(EspalexaJsonWriter& json, uint8_t deviceId, uint32_t part)
+  {
+    if (part > 0) return false;
+    deviceJson(json, deviceId);
+    return true;
+  }
+
+  //brightness of a device, as far as the network side may read it
+  uint8_t deviceValue(uint8_t slot)
+  {
+    #ifdef ESPALEXA_STATE_SNAPSHOTS
+    return stateSnapshotValue[slot];
+    #else
+    return devices[slot]->getValue();
+    #endif
+  }
+
+  //group JSON, the action reflects the brightest device of the group
+  void groupJson(EspalexaJsonWriter& json, uint8_t groupId)
+  {
+    groupId--;
+    if (groupId >= currentGroupCount) {json.print("{}"); return;} //error
+    EspalexaGroup* g = groups[groupId];
+
+    json.print("{\"name\":\""); json.printEscaped(g->getNameCStr());
+    json.print("\",\"lights\":[");
+    bool anyOn = false, allOn = true, first = true;
+    uint8_t bri = 0;
+    for (uint8_t i = 0; i < g->getDeviceCount(); i++)
+    {
+      EspalexaDevice* dev = g->getDevice(i);
+      if (!isDevice(dev)) continue;
+      uint8_t val = deviceValue(dev->getId());
+      anyOn |= (val > 0);
+      allOn &= (val > 0);
+      if (val > bri) bri = val;
+      if (!first) json.write(',');
+      first = false;
+      json.write('"'); json.print(encodeLightId(dev->getId()+1)); json.write('"');
+    }
+    if (first) allOn = false;
+    json.print("],\"type\":\"Room\",\"class\":\"Other\",\"state\":{\"all_on\":"); json.print(boolString(allOn));
+    json.print(",\"any_on\":"); json.print(boolString(anyOn));
+    json.print("},\"action\":{\"on\":"); json.print(boolString(anyOn));
+    json.print(",\"bri\":"); json.print((uint32_t)(bri ? bri-1 : 0));
+    json.print("}}");
+  }
+
+  //all groups JSON object, keyed by group ID. Part n is the n-th group, the last part closes the object
+  bool groupsJson(EspalexaJsonWriter& json, uint8_t, uint32_t part)
+  {
+    if (part > currentGroupCount) return false;
+    if (part == 0) json.write('{');
+    if (part == currentGroupCount) {json.write('}'); return true;}
+    if (part > 0) json.write(',');
+    json.write('"'); json.print(part+1); json.print("\":");
+    groupJson(json, part+1);
+    return true;
+  }
+
+  bool singleGroupJson(EspalexaJsonWriter& json, uint8_t groupId, uint32_t part)
+  {
+    if (part > 0) return false;
+    groupJson(json, groupId);
+    return true;
+  }
+
+  //renders one part of a response and returns true, or false if there are no more parts.
+  //Responses are split into parts (e.g. one per light), so the async server can send them part by part
+  typedef bool (Espalexa::*JsonRenderFunction)(EspalexaJsonWriter& json, uint8_t arg, uint32_t part);
+
+  void renderJson(EspalexaJsonWriter& json, JsonRenderFunction render, uint8_t arg)
+  {
+    for (uint32_t part = 0; (this->*render)(json, arg, part); part++);
+  }
+
+  #ifdef ESPALEXA_ASYNC
+  //an async response in progress. Every part is rendered once, when the previous one is sent completely,
+  //so the chunks fit together even if the devices change in between, and the response is rendered only once
+  struct JsonResponse {
+    uint32_t part = 0; //next part to render
+    char* buf = nullptr;
+    size_t size = 0, len = 0, sent = 0;
+
+    ~JsonResponse() {free(buf);}
+  };
+
+  bool renderNextPart(JsonResponse& r, JsonRenderFunction render, uint8_t arg)
+  {
+    for (;;)
+    {
+      EspalexaJsonWriter json(r.buf, r.size);
+      if (!(this->*render)(json, arg, r.part)) return false;
+      if (json.total() <= r.size)
+      {
+        r.part++;
+        r.len = json.total();
+        r.sent = 0;
+        return true;
+      }
+      //grow the buffer to the largest part so far and render the part again
+      char* b = (char*)realloc(r.buf, json.total() + 32);
+      if (b == nullptr) return false; //ends the response early
+      r.buf = b;
+      r.size = json.total() + 32;
+    }
+  }
+  #endif
+
+  //stream a JSON response without building it in memory
+  void sendJson(const EspalexaRequest& req, JsonRenderFunction render, uint8_t arg)
+  {
+    #ifdef ESPALEXA_ASYNC
+    //the filler is called once per TCP chunk and continues where the previous chunk stopped
+    std::shared_ptr<JsonResponse> r = std::make_shared<JsonResponse>();
+    req.http->send(req.http->beginChunkedResponse("application/json", [this, r, render, arg](uint8_t* buffer, size_t maxLen, size_t) -> size_t {
+      size_t n = 0;
+      while (n < maxLen)
+      {
+        if (r->sent == r->len)
+        {
+          if (!renderNextPart(*r, render, arg)) break;
+          continue;
+        }
+        size_t c = r->len - r->sent;
+        if (c > maxLen - n) c = maxLen - n;
+        memcpy(buffer + n, r->buf + r->sent, c);
+        r->sent += c;
+        n += c;
+      }
+      return n;
+    }));
+    #else
+    #ifdef ESPALEXA_COMMAND_QUEUE
+    //processCommands() may publish new states while the response is rendered, so the length is unknown (chunked transfer encoding)
+    req.http->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    #else
+    //first pass only counts the bytes for Content-Length, the second one sends them in chunks
+    EspalexaJsonWriter counter(nullptr, 0);
+    renderJson(counter, render, arg);
+    req.http->setContentLength(counter.total());
+    #endif
+    req.http->send(200, "application/json", "");
+
+    char chunk[ESPALEXA_JSON_CHUNK];
+    EspalexaJsonWriter json(chunk, sizeof(chunk), sendJsonChunk, req.http);
+    renderJson(json, render, arg);
+    json.flush();
+    #ifdef ESPALEXA_COMMAND_QUEUE
+    req.http->sendContent(""); //last chunk
+    #endif
+    #endif
+  }
+
+  #ifndef ESPALEXA_ASYNC
+  static void sendJsonChunk(void* ctx, const char* data, size_t len)
+  {
+    static_cast<EspalexaHttp*>(ctx)->sendContent_P(data, len); //works on RAM buffers as well
+  }
+  #endif
+  
+  //apply a parsed state change to a device and notify the application.
+  //If group is set (a group ID), the group callback is notified instead of the device callback.
+  //groupPending: the group callback is still pending from an earlier command, see applyGroupCommand()
+  void applyCommand(EspalexaDevice* dev, const EspalexaCommand& cmd, uint8_t group = 0, bool notify = true, bool groupPending = false)
+  {
+    #ifndef ESPALEXA_NO_TRANSITIONS
+    //a new command replaces a running transition, starting from the state it reached
+    uint8_t slot = dev->getId();
+    stopTransition(slot);
+    uint8_t fromBri = dev->getValue();
+    EspalexaColorMode fromMode = dev->getColorMode();
+    uint16_t fromColor[2];
+    getDeviceColor(dev, fromMode, fromColor);
+    bool fade = cmd.has(EspalexaCommandField::transitiontime) && cmd.transitiontime > 0;
+    #endif
+    //changes merged into a callback that is still pending are reported together
+    if (!callbackDue[dev->getId()] && !groupPending) dev->setPropertyChanged(EspalexaDeviceProperty::none);
+    
+    if (cmd.has(EspalexaCommandField::on) && !cmd.on) //OFF command
+    {
+      dev->setValue(0);
+      dev->setPropertyChanged(EspalexaDeviceProperty::off);
+      #ifndef ESPALEXA_NO_TRANSITIONS
+      if (fade && fromBri) {startTransition(slot, fromBri, fromMode, fromColor, cmd.transitiontime, group, notify); return;}
+      #endif
+      if (!notify) return;
+      if (group) triggerGroupCallback(group); else triggerCallback(dev);
+      return;
+    }
+    
+    if (cmd.has(EspalexaCommandField::on)) //ON command
+    {
+      dev->setValue(dev->getLastValue());
+      dev->setPropertyChanged(EspalexaDeviceProperty::on);
+    }
+    
+    if (cmd.has(EspalexaCommandField::bri)) //BRIGHTNESS command
+    {
+      dev->setValue((cmd.bri == 255) ? 255 : cmd.bri+1);
+      dev->setPropertyChanged(EspalexaDeviceProperty::bri);
+    }
+    
+    if (cmd.has(EspalexaCommandField::xy)) //COLOR command (XY mode)
+    {
+      dev->setColorXYFixed(cmd.x, cmd.y);
+      dev->setPropertyChanged(EspalexaDeviceProperty::xy);
+    }
+    
+    if (cmd.has(EspalexaCommandField::hue) || cmd.has(EspalexaCommandField::sat)) //COLOR command (HS mode)
+    {
+      dev->setColor(cmd.has(EspalexaCommandField::hue) ? cmd.hue : dev->getHue(), cmd.has(EspalexaCommandField::sat) ? cmd.sat : dev->getSat());
+      dev->setPropertyChanged(EspalexaDeviceProperty::hs);
+    }
+    
+    if (cmd.has(EspalexaCommandField::ct)) //COLOR TEMP command (white spectrum)
+    {
+      dev->setColor(cmd.ct);
+      dev->setPropertyChanged(EspalexaDeviceProperty::ct);
+    }
+    
+    #ifndef ESPALEXA_NO_TRANSITIONS
+    if (fade) {startTransition(slot, fromBri, fromMode, fromColor, cmd.transitiontime, group, notify); return;}
+    #endif
+    if (!notify) return;
+    if (group) triggerGroupCallback(group); else triggerCallback(dev);
+  }
+
+  //for the addDevice() overloads that take a name, the device belongs to Espalexa
+  bool addOwnedDevice(const EspalexaDevice& d)
+  {
+    if (currentDeviceCount >= ESPALEXA_MAXDEVICES) return false;
+    #ifdef ESPALEXA_STATIC_DEVICES
+    devicePool[currentDeviceCount] = d;
+    return addDevice(&devicePool[currentDeviceCount]);
+    #else
+    ownedDevices[currentDeviceCount] = true;
+    return addDevice(new EspalexaDevice(d));
+    #endif
+  }
+  
+  //is one of our devices (a group may contain devices that were never added)
+  bool isDevice(EspalexaDevice* dev)
+  {
+    return dev != nullptr && dev->getId() < currentDeviceCount && devices[dev->getId()] == dev;
+  }
+
+  //one parsed state change for all devices of a group. With a group callback, only that is called (once)
+  void applyGroupCommand(EspalexaGroup* g, const EspalexaCommand& cmd)
+  {
+    uint8_t group = g->hasCallback() ? g->getId()+1 : 0;
+    //decided once, the first device already makes the group callback pending
+    bool pending = group && groupCallbackDue[group-1];
+    for (uint8_t i = 0; i < g->getDeviceCount(); i++)
+    {
+      EspalexaDevice* dev = g->getDevice(i);
+      if (isDevice(dev)) applyCommand(dev, cmd, group, true, pending);
+    }
+  }
+
+  //runs the device callback from loop() instead of the request handler, merging changes within the debounce time
+  void triggerCallback(EspalexaDevice* dev)
+  {
+    uint8_t slot = dev->getId();
+    callbackStats.requested++;
+    if (callbackDue[slot]) {callbackStats.coalesced++; return;}
+    callbackDue[slot] = millis() + callbackDebounce;
+    if (callbackDue[slot] == 0) callbackDue[slot] = 1;
+    pendingCallbacks[pendingCallbackCount++] = slot;
+  }
+
+  //like triggerCallback(), for a group ID
+  void triggerGroupCallback(uint8_t group)
+  {
+    callbackStats.requested++;
+    if (groupCallbackDue[group-1]) {callbackStats.coalesced++; return;}
+    groupCallbackDue[group-1] = millis() + callbackDebounce;
+    if (groupCallbackDue[group-1] == 0) groupCallbackDue[group-1] = 1;
+    pendingGroupCallbackCount++;
+  }
+
+  void dispatchCallbacks()
+  {
+    uint32_t now = millis();
+    for (uint8_t i = 0; pendingGroupCallbackCount && i < currentGroupCount; i++)
+    {
+      if (!groupCallbackDue[i] || (int32_t)(now - groupCallbackDue[i]) < 0) continue;
+      groupCallbackDue[i] = 0;
+      pendingGroupCallbackCount--;
+      callbackStats.delivered++;
+      groups[i]->doCallback();
+    }
+    for (uint8_t i = 0; i < pendingCallbackCount;)
+    {
+      uint8_t slot = pendingCallbacks[i];
+      if ((int32_t)(now - callbackDue[slot]) < 0) {i++; continue;}
+      callbackDue[slot] = 0;
+      pendingCallbacks[i] = pendingCallbacks[--pendingCallbackCount];
+      callbackStats.delivered++;
+      devices[slot]->doCallback();
+    }
+  }
+
+  #ifdef ESPALEXA_COMMAND_HANDOFF
+  //applies the commands handed over by the request handlers, on the task that owns the devices
+  void applyQueuedCommands()
+  {
+    QueuedCommand q;
+    while (commandQueue.pop(q))
+    {
+      if (q.group) applyGroupCommand(groups[q.group-1], q.cmd);
+      else applyCommand(devices[q.slot], q.cmd);
+    }
+  }
+  #endif
+
+  //transition frames and callbacks, on the task that owns the devices
+  void updateDevices()
+  {
+    #ifndef ESPALEXA_NO_TRANSITIONS
+    if (activeTransitionCount && millis() - lastFrame >= 1000 / ESPALEXA_TRANSITION_FPS)
+    {
+      lastFrame = millis();
+      runTransitions(lastFrame);
+    }
+    #endif
+    if (pendingCallbackCount || pendingGroupCallbackCount) dispatchCallbacks();
+  }
+
+  #ifdef ESPALEXA_STATE_SNAPSHOTS
+  void publishState(uint8_t slot)
+  {
+    uint16_t version = devices[slot]->getVersion();
+    char state[ESPALEXA_STATE_CACHE];
+    EspalexaJsonWriter json(state, sizeof(state));
+    deviceStateJson(json, devices[slot]);
+    stateSnapshot[slot].write(state, json.length());
+    stateSnapshotVersion[slot] = version;
+    stateSnapshotValue[slot] = devices[slot]->getValue();
+  }
+
+  //on the task that owns the devices, after they were changed
+  void publishChangedStates()
+  {
+    for (uint8_t i = 0; i < currentDeviceCount; i++)
+    {
+      if (stateSnapshotVersion[i] != devices[i]->getVersion()) publishState(i);
+    }
+  }
+  #endif
+
+  #ifndef ESPALEXA_NO_TRANSITIONS
+  void getDeviceColor(EspalexaDevice* dev, EspalexaColorMode mode, uint16_t* c)
+  {
+    c[0] = 0; c[1] = 0;
+    switch (mode)
+    {
+      case EspalexaColorMode::ct: c[0] = dev->getCt(); break;
+      case EspalexaColorMode::hs: c[0] = dev->getHue(); c[1] = dev->getSat(); break;
+      case EspalexaColorMode::xy: c[0] = dev->getXFixed(); c[1] = dev->getYFixed(); break;
+      default: break;
+    }
+  }
+
+  void setDeviceColor(EspalexaDevice* dev, EspalexaColorMode mode, const uint16_t* c)
+  {
+    switch (mode)
+    {
+      case EspalexaColorMode::ct: dev->setColor(c[0]); break;
+      case EspalexaColorMode::hs: dev->setColor(c[0], (uint8_t)c[1]); break;
+      case EspalexaColorMode::xy: dev->setColorXYFixed(c[0], c[1]); break;
+      default: break;
+    }
+  }
+
+  //the device is already set to the target state, remember it and go back to the start.
+  //Color is only faded within one color mode, a change of mode is applied at the start
+  void startTransition(uint8_t slot, uint8_t fromBri, EspalexaColorMode fromMode, const uint16_t* fromColor, uint16_t time, uint8_t group, bool notify)
+  {
+    EspalexaDevice* dev = devices[slot];
+    Transition& t = transitions[slot];
+    t.group = group;
+    t.notify = notify;
+    t.start = millis();
+    t.duration = (uint32_t)time * 100;
+    t.fromBri = fromBri;
+    t.toBri = dev->getValue();
+    t.mode = dev->getColorMode();
+    getDeviceColor(dev, t.mode, t.toColor);
+    if (t.mode == fromMode && (t.toColor[0] != fromColor[0] || t.toColor[1] != fromColor[1]))
+    {
+      t.fromColor[0] = fromColor[0]; t.fromColor[1] = fromColor[1];
+      setDeviceColor(dev, t.mode, t.fromColor);
+    } else t.mode = EspalexaColorMode::none;
+    dev->setValue(fromBri);
+    if (activeTransitionCount == 0) lastFrame = t.start; //first frame one frame time from now
+    activeTransitions[activeTransitionCount++] = slot;
+  }
+
+  void stopTransition(uint8_t slot)
+  {
+    for (uint8_t i = 0; i < activeTransitionCount; i++)
+    {
+      if (activeTransitions[i] != slot) continue;
+      activeTransitions[i] = activeTransitions[--activeTransitionCount];
+      return;
+    }
+  }
+
+  //progress is 0-4096
+  static uint16_t lerp(uint16_t from, uint16_t to, uint32_t progress)
+  {
+    return from + (((int32_t)to - from) * (int32_t)progress >> 12);
+  }
+
+  void runTransitions(uint32_t now)
+  {
+    bool groupFrame[ESPALEXA_MAXGROUPS] = {};
+    for (uint8_t i = 0; i < activeTransitionCount;)
+    {
+      uint8_t slot = activeTransitions[i];
+      EspalexaDevice* dev = devices[slot];
+      Transition& t = transitions[slot];
+      uint32_t elapsed = now - t.start;
+      bool done = elapsed >= t.duration;
+      uint32_t progress = done ? 4096 : (uint64_t)elapsed * 4096 / t.duration;
+
+      uint8_t bri = lerp(t.fromBri, t.toBri, progress);
+      if (done && bri == 0 && t.fromBri) dev->setValue(t.fromBri); //fading out, so the next ON restores the brightness from before
+      if (bri != dev->getValue()) dev->setValue(bri);
+      if (t.mode != EspalexaColorMode::none)
+      {
+        uint16_t c[2] = {lerp(t.fromColor[0], t.toColor[0], progress), lerp(t.fromColor[1], t.toColor[1], progress)};
+        if (t.mode == EspalexaColorMode::hs) //shortest way around the color wheel
+        {
+          int32_t d = (int32_t)t.toColor[0] - t.fromColor[0];
+          if (d > 32767) d -= 65536;
+          if (d < -32768) d += 65536;
+          c[0] = t.fromColor[0] + (d * (int32_t)progress >> 12);
+        }
+        setDeviceColor(dev, t.mode, c);
       }
+      if (t.group) groupFrame[t.group-1] = true; //one callback per frame for all devices of the group
+      else if (t.notify) dev->doCallback();
+
+      if (done) activeTransitions[i] = activeTransitions[--activeTransitionCount];
+      else i++;
+    }
+    for (uint8_t i = 0; i < currentGroupCount; i++)
+    {
+      if (groupFrame[i]) groups[i]->doCallback();
+    }
+  }
+  #endif
+  
+  //part of the request URL, points into the URL string
+  struct ApiSpan {
+    const char* p = nullptr;
+    uint8_t len = 0;
+    
+    bool equals(const char* s) const
+    {
+      return strlen(s) == len && !memcmp(p, s, len);
+    }
+  };
+  
+  //split /api/<user>/<collection>/<id>/<sub> in one pass
+  struct ApiPath {
+    ApiSpan collection, sub;
+    bool hasId = false;
+    uint32_t id = 0; //0 if not numeric, like toInt()
+  };
+  
+  typedef void (Espalexa::*ApiHandler)(const EspalexaRequest& req, uint32_t id);
+  
+  struct ApiRoute {
+    const char* collection;
+    bool hasId;
+    const char* sub; //nullptr for none
+    ApiHandler handler;
+  };
+  
+  bool parseApiPath(const char* url, ApiPath& path)
+  {
+    ApiSpan seg[5];
+    uint8_t n = 0;
+    while (*url && *url != '?' && n < 5)
+    {
+      if (*url == '/') {url++; continue;}
+      seg[n].p = url;
+      while (*url && *url != '/' && *url != '?') url++;
+      uint16_t len = url - seg[n].p;
+      seg[n].len = (len > 255) ? 255 : len;
+      n++;
+    }
+    if (n == 0 || !seg[0].equals("api")) return false;
+    path.collection = seg[2];
+    path.hasId = (n > 3);
+    for (uint8_t i = 0; i < seg[3].len && seg[3].p[i] >= '0' && seg[3].p[i] <= '9'; i++) path.id = path.id*10 + (seg[3].p[i] - '0');
+    path.sub = seg[4];
+    return true;
+  }
+  
+  bool handleApiCall(const EspalexaRequest& req, const char* url)
+  {
+    EA_DEBUGLN("AlexaApiCall");
+    ApiPath path;
+    if (!parseApiPath(url, path)) return false; //return if not an API call
+    EA_DEBUGLN("ok");
+
+    const char* devicetype = strstr(req.body, "devicetype");
+    if (devicetype != nullptr && devicetype > req.body) //client wants a hue api username, we don't care and give static
+    {
+      EA_DEBUGLN("devType");
+      req.http->send(200, "application/json", "[{\"success\":{\"username\":\"2WLEDHardQrI3WHYTHoMcXHgEspsM8ZZRpSKtBQr\"}}]");
+      return true;
+    }
+
+    static const ApiRoute routes[] = {
+      {"lights", false, nullptr, &Espalexa::serveLights},     //client wants all lights
+      {"lights", true,  nullptr, &Espalexa::serveLight},      //client wants one light
+      {"lights", true,  "state", &Espalexa::serveLightState}, //client wants to control light
+      {"groups", false, nullptr, &Espalexa::serveGroups},     //client wants all groups
+      {"groups", true,  nullptr, &Espalexa::serveGroup},      //client wants one group
+      {"groups", true,  "action", &Espalexa::serveGroupAction}, //client wants to control all lights of a group
+    };
+    for (const ApiRoute& r : routes)
+    {
+      if (!path.collection.equals(r.collection) || path.hasId != r.hasId) continue;
+      if (r.sub == nullptr ? path.sub.len != 0 : !path.sub.equals(r.sub)) continue;
+      (this->*r.handler)(req, path.id);
+      return true;
+    }
+
+    //we don't care about other api commands at this time and send empty JSON
+    req.http->send(200, "application/json", "{}");
+    return true;
+  }
+
+  //index into devices[] for a light ID from the URL, -1 if there is no such light
+  int lightIndex(uint32_t id)
+  {
+    uint32_t idx = decodeLightId(id);
+    if (idx == 0 || idx > currentDeviceCount) return -1;
+    return idx - 1;
+  }
+  
+  void serveLights(const EspalexaRequest& req, uint32_t)
+  {
+    EA_DEBUGLN("lAll");
+    sendJson(req, &Espalexa::lightsJson, 0);
+  }
+  
+  void serveLight(const EspalexaRequest& req, uint32_t id)
+  {
+    EA_DEBUG("l"); EA_DEBUGLN(id);
+    if (id == 0) {serveLights(req, id);  return;} //e.g. /lights/new
+    int idx = lightIndex(id);
+    if (idx < 0)
+    {
+      req.http->send(200, "application/json", "{}");
+    } else {
+      sendJson(req, &Espalexa::lightJson, idx+1);
     }
-    json += ",\"alert\":\"none";
-    if (static_cast<uint8_t>(dev->getType()) > 1) json += "\",\"colormode\":\"" + modeString(dev->getColorMode());
-    json += "\",\"mode\":\"homeautomation\",\"reachable\":true},";
-    json += "\"type\":\"" + typeString(dev->getType());
-    json += "\",\"name\":\"" + dev->getName();
-    json += "\",\"modelid\":\"" + modelidString(dev->getType());
-    json += "\",\"manufacturername\":\"Philips\",\"productname\":\"E" + String(static_cast<uint8_t>(dev->getType()));
-    json += "\",\"uniqueid\":\"" + String(encodeLightId(deviceId+1));
-    json += "\",\"swversion\":\"espalexa-2.4.4\"}";
+  }
+  
+  void serveLightState(const EspalexaRequest& req, uint32_t id)
+  {
+    req.http->send(200, "application/json", "[{\"success\":{\"/lights/1/state/\": true}}]");
+    
+    EA_DEBUG("ls"); EA_DEBUGLN(id);
+    int idx = lightIndex(id);
+    if (idx < 0) return; //return if invalid ID
     
-    return json;
+    #ifdef ESPALEXA_COMMAND_HANDOFF
+    QueuedCommand q;
+    q.slot = idx;
+    if (!q.cmd.parse(req.body, req.len)) {EA_DEBUGLN("Malformed state body");}
+    if (!commandQueue.push(q)) {droppedCommands++; EA_DEBUGLN("Command queue full");}
+    #else
+    EspalexaCommand cmd;
+    if (!cmd.parse(req.body, req.len)) {EA_DEBUGLN("Malformed state body");}
+    applyCommand(devices[idx], cmd);
+    
+    #ifdef ESPALEXA_DEBUG
+    if (cmd.fields == 0)
+      EA_DEBUGLN("STATE REQ WITHOUT BODY (likely Content-Type issue #6)");
+    #endif
+    #endif
+  }
+  
+  void serveGroups(const EspalexaRequest& req, uint32_t)
+  {
+    EA_DEBUGLN("gAll");
+    sendJson(req, &Espalexa::groupsJson, 0);
+  }
+  
+  void serveGroup(const EspalexaRequest& req, uint32_t id)
+  {
+    EA_DEBUG("g"); EA_DEBUGLN(id);
+    if (id == 0 || id > currentGroupCount)
+    {
+      req.http->send(200, "application/json", "{}");
+    } else {
+      sendJson(req, &Espalexa::singleGroupJson, id);
+    }
+  }
+  
+  void serveGroupAction(const EspalexaRequest& req, uint32_t id)
+  {
+    req.http->send(200, "application/json", "[{\"success\":{\"/groups/1/action/\": true}}]");
+    
+    EA_DEBUG("ga"); EA_DEBUGLN(id);
+    if (id == 0 || id > currentGroupCount) return; //return if invalid ID
+    
+    #ifdef ESPALEXA_COMMAND_HANDOFF
+    QueuedCommand q;
+    q.slot = 0;
+    q.group = id;
+    if (!q.cmd.parse(req.body, req.len)) {EA_DEBUGLN("Malformed action body");}
+    if (!commandQueue.push(q)) {droppedCommands++; EA_DEBUGLN("Command queue full");}
+    #else
+    EspalexaCommand cmd;
+    if (!cmd.parse(req.body, req.len)) {EA_DEBUGLN("Malformed action body");}
+    applyGroupCommand(groups[id-1], cmd);
+    #endif
   }
   
   //Espalexa status page /espalexa
   #ifndef ESPALEXA_NO_SUBPAGE
-  void servePage()
+  void servePage(EspalexaHttp* http)
   {
     EA_DEBUGLN("HTTP Req espalexa ...\n");
     String res = "Hello from Espalexa!\r\n\r\n";
     for (int i=0; i<currentDeviceCount; i++)
     {
       EspalexaDevice* dev = devices[i];
+      #ifdef ESPALEXA_STATE_SNAPSHOTS
+      char state[ESPALEXA_STATE_CACHE + 1];
+      state[stateSnapshot[i].read(state)] = 0; //the device itself belongs to the application task
+      res += "State of device " + String(i+1) + " (" + dev->getName() + "): " + state + "\r\n";
+      continue;
+      #endif
       res += "Value of device " + String(i+1) + " (" + dev->getName() + "): " + String(dev->getValue()) + " (" + typeString(dev->getType());
       if (static_cast<uint8_t>(dev->getType()) > 1) //color support
       {
-        res += ", colormode=" + modeString(dev->getColorMode()) + ", r=" + String(dev->getR()) + ", g=" + String(dev->getG()) + ", b=" + String(dev->getB());
+        res += ", colormode=" + String(modeString(dev->getColorMode())) + ", r=" + String(dev->getR()) + ", g=" + String(dev->getG()) + ", b=" + String(dev->getB());
         res +=", ct=" + String(dev->getCt()) + ", hue=" + String(dev->getHue()) + ", sat=" + String(dev->getSat()) + ", x=" + String(dev->getX()) + ", y=" + String(dev->getY());
       }
       res += ")\r\n";
     }
     res += "\r\nFree Heap: " + (String)ESP.getFreeHeap();
     res += "\r\nUptime: " + (String)millis();
+    #ifdef ESPALEXA_DEBUG
+    res += "\r\nColor conversions: " + (String)EspalexaDevice::getConversionCount() + " (only counted if ESPALEXA_DEBUG is a global build flag)";
+    #endif
     res += "\r\n\r\nEspalexa library v2.4.4 by Christian Schwinne 2020";
-    server->send(200, "text/plain", res);
+    http->send(200, "text/plain", res);
   }
   #endif
 
   //not found URI (only if internal webserver is used)
-  void serveNotFound()
+  void serveNotFound(EspalexaHttp* http)
   {
     EA_DEBUGLN("Not-Found HTTP call:");
     #ifndef ESPALEXA_ASYNC
-    EA_DEBUGLN("URI: " + server->uri());
-    EA_DEBUGLN("Body: " + server->arg(0));
-    if(!handleAlexaApiCall(server->uri(), server->arg(0)))
-    #else
-    EA_DEBUGLN("URI: " + server->url());
+    EA_DEBUGLN("URI: " + http->uri());
+    String body = http->arg(0);
     EA_DEBUGLN("Body: " + body);
-    if(!handleAlexaApiCall(server))
+    EspalexaRequest req = {http, body.c_str(), body.length()};
+    if(!handleApiCall(req, http->uri().c_str()))
+    #else
+    EA_DEBUGLN("URI: " + http->url());
+    if(!handleAlexaApiCall(http))
     #endif
-      server->send(404, "text/plain", "Not Found (espalexa-internal)");
+      http->send(404, "text/plain", "Not Found (espalexa-internal)");
   }
 
-  //send description.xml device property page
-  void serveDescription()
+  //render SSDP response and description.xml once; redone only if the IP address changes (MAC is read in begin())
+  void renderDiscovery()
   {
-    EA_DEBUGLN("# Responding to description.xml ... #\n");
     IPAddress localIP = WiFi.localIP();
+    if (discoveryRendered && localIP == discoveryIP) return;
+    discoveryIP = localIP;
+    discoveryRendered = true;
     char s[16];
     sprintf(s, "%d.%d.%d.%d", localIP[0], localIP[1], localIP[2], localIP[3]);
+    const char* mac = escapedMac.c_str();
 
-    String setup_xml = "<?xml version=\"1.0\" ?>"
+    int len = snprintf_P(descriptionXml, sizeof(descriptionXml), PSTR("<?xml version=\"1.0\" ?>"
         "<root xmlns=\"urn:schemas-upnp-org:device-1-0\">"
         "<specVersion><major>1</major><minor>0</minor></specVersion>"
-        "<URLBase>http://"+ String(s) +":80/</URLBase>"
+        "<URLBase>http://%s:80/</URLBase>"
         "<device>"
           "<deviceType>urn:schemas-upnp-org:device:Basic:1</deviceType>"
-          "<friendlyName>Espalexa ("+ String(s) +")</friendlyName>"
+          "<friendlyName>Espalexa (%s)</friendlyName>"
           "<manufacturer>Royal Philips Electronics</manufacturer>"
           "<manufacturerURL>http://www.philips.com</manufacturerURL>"
           "<modelDescription>Philips hue Personal Wireless Lighting</modelDescription>"
           "<modelName>Philips hue bridge 2012</modelName>"
           "<modelNumber>929000226503</modelNumber>"
           "<modelURL>http://www.meethue.com</modelURL>"
-          "<serialNumber>"+ escapedMac +"</serialNumber>"
-          "<UDN>uuid:2f402f80-da50-11e1-9b23-"+ escapedMac +"</UDN>"
+          "<serialNumber>%s</serialNumber>"
+          "<UDN>uuid:2f402f80-da50-11e1-9b23-%s</UDN>"
           "<presentationURL>index.html</presentationURL>"
         "</device>"
-        "</root>";
-          
-    server->send(200, "text/xml", setup_xml.c_str());
+        "</root>"), s, s, mac, mac);
+    descriptionXmlLen = (len < (int)sizeof(descriptionXml)) ? len : sizeof(descriptionXml) -1;
+
+    len = snprintf_P(searchResponse, sizeof(searchResponse), PSTR(
+      "HTTP/1.1 200 OK\r\n"
+      "EXT:\r\n"
+      "CACHE-CONTROL: max-age=100\r\n" // SSDP_INTERVAL
+      "LOCATION: http://%s:80/description.xml\r\n"
+      "SERVER: FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0\r\n" // _modelName, _modelNumber
+      "hue-bridgeid: %s\r\n"
+      "ST: urn:schemas-upnp-org:device:basic:1\r\n"  // _deviceType
+      "USN: uuid:2f402f80-da50-11e1-9b23-%s::ssdp:all\r\n" // _uuid::_deviceType
+      "\r\n"), s, mac, mac);
+    searchResponseLen = (len < (int)sizeof(searchResponse)) ? len : sizeof(searchResponse) -1;
+  }
+
+  //send description.xml device property page
+  void serveDescription(EspalexaHttp* http)
+  {
+    EA_DEBUGLN("# Responding to description.xml ... #\n");
+    renderDiscovery();
+    #ifdef ESPALEXA_ASYNC
+    http->send_P(200, "text/xml", (const uint8_t*)descriptionXml, descriptionXmlLen);
+    #else
+    http->send_P(200, "text/xml", descriptionXml, descriptionXmlLen); //works on RAM buffers as well
+    #endif
     
     EA_DEBUG("Sending :");
-    EA_DEBUGLN(setup_xml);
+    EA_DEBUGLN(descriptionXml);
   }
   
+  #ifdef ESPALEXA_ASYNC
+  //collects the body chunks of a request in one buffer, which the request frees when it is done
+  static void receiveBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)
+  {
+    if (total > ESPALEXA_MAX_BODY) return;
+    if (index == 0 && request->_tempObject == nullptr)
+    {
+      char* b = (char*)malloc(total + 1);
+      if (b == nullptr) return;
+      b[total] = 0;
+      request->_tempObject = b;
+    }
+    if (request->_tempObject == nullptr || index + len > total) return;
+    memcpy((char*)request->_tempObject + index, data, len);
+  }
+  #endif
+
   //init the server
   void startHttpServer()
   {
     #ifdef ESPALEXA_ASYNC
     if (serverAsync == nullptr) {
       serverAsync = new AsyncWebServer(80);
-      serverAsync->onNotFound([=](AsyncWebServerRequest *request){server = request; serveNotFound();});
+      serverAsync->onNotFound([=](AsyncWebServerRequest *request){serveNotFound(request);});
     }
     
-    serverAsync->onRequestBody([=](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
-      char b[len +1];
-      b[len] = 0;
-      memcpy(b, data, len);
-      body = b; //save the body so we can use it for the API call
-      EA_DEBUG("Received body: ");
-      EA_DEBUGLN(body);
-    });
+    serverAsync->onRequestBody(receiveBody);
     #ifndef ESPALEXA_NO_SUBPAGE
-    serverAsync->on("/espalexa", HTTP_GET, [=](AsyncWebServerRequest *request){server = request; servePage();});
+    serverAsync->on("/espalexa", HTTP_GET, [=](AsyncWebServerRequest *request){servePage(request);});
     #endif
-    serverAsync->on("/description.xml", HTTP_GET, [=](AsyncWebServerRequest *request){server = request; serveDescription();});
+    serverAsync->on("/description.xml", HTTP_GET, [=](AsyncWebServerRequest *request){serveDescription(request);});
     serverAsync->begin();
     
     #else
@@ -272,42 +1201,125 @@ private:
       #else
       server = new ESP8266WebServer(80);  
       #endif
-      server->onNotFound([=](){serveNotFound();});
+      server->onNotFound([=](){serveNotFound(server);});
     }
 
     #ifndef ESPALEXA_NO_SUBPAGE
-    server->on("/espalexa", HTTP_GET, [=](){servePage();});
+    server->on("/espalexa", HTTP_GET, [=](){servePage(server);});
     #endif
-    server->on("/description.xml", HTTP_GET, [=](){serveDescription();});
+    server->on("/description.xml", HTTP_GET, [=](){serveDescription(server);});
     server->begin();
     #endif
   }
 
   //respond to UDP SSDP M-SEARCH
-  void respondToSearch()
+  void respondToSearch(IPAddress ip, uint16_t port)
   {
-    IPAddress localIP = WiFi.localIP();
-    char s[16];
-    sprintf(s, "%d.%d.%d.%d", localIP[0], localIP[1], localIP[2], localIP[3]);
+    renderDiscovery();
+    espalexaUdp.beginPacket(ip, port);
+    espalexaUdp.write((const uint8_t*)searchResponse, searchResponseLen);
+    espalexaUdp.endPacket();                    
+  }
 
-    String response = 
-      "HTTP/1.1 200 OK\r\n"
-      "EXT:\r\n"
-      "CACHE-CONTROL: max-age=100\r\n" // SSDP_INTERVAL
-      "LOCATION: http://"+ String(s) +":80/description.xml\r\n"
-      "SERVER: FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0\r\n" // _modelName, _modelNumber
-      "hue-bridgeid: "+ escapedMac +"\r\n"
-      "ST: urn:schemas-upnp-org:device:basic:1\r\n"  // _deviceType
-      "USN: uuid:2f402f80-da50-11e1-9b23-"+ escapedMac +"::ssdp:all\r\n" // _uuid::_deviceType
-      "\r\n";
+  //value of the MX header (seconds the requester waits for replies), 0 if there is none
+  uint8_t searchMx(const char* p)
+  {
+    for (const char* line = p; *p; p++)
+    {
+      if (*p == '\n') {line = p+1; continue;}
+      if (p != line || (p[0] != 'M' && p[0] != 'm') || (p[1] != 'X' && p[1] != 'x') || p[2] != ':') continue;
+      p += 3;
+      while (*p == ' ') p++;
+      uint8_t mx = 0;
+      for (; *p >= '0' && *p <= '9' && mx <= ESPALEXA_SSDP_MAX_MX; p++) mx = mx*10 + (*p - '0');
+      return (mx > ESPALEXA_SSDP_MAX_MX) ? ESPALEXA_SSDP_MAX_MX : mx;
+    }
+    return 0;
+  }
 
-    espalexaUdp.beginPacket(espalexaUdp.remoteIP(), espalexaUdp.remotePort());
-    #ifdef ARDUINO_ARCH_ESP32
-    espalexaUdp.write((uint8_t*)response.c_str(), response.length());
-    #else
-    espalexaUdp.write(response.c_str());
-    #endif
-    espalexaUdp.endPacket();                    
+  //M-SEARCH for a device type we emulate
+  bool isSearchRequest(const char* packet)
+  {
+    if (strstr(packet, "M-SEARCH") == nullptr) return false;
+    return strstr(packet, "upnp:rootdevice") || strstr(packet, "asic:1") || strstr(packet, "ssdp:all");
+  }
+
+  //drain pending datagrams, but at most udpPacketBudget of them and for about udpTimeBudget microseconds per call
+  void receiveSearch()
+  {
+    uint32_t start = micros();
+    for (uint8_t n = 0; n < udpPacketBudget; n++)
+    {
+      if (n > 0 && micros() - start >= udpTimeBudget) break;
+      int packetSize = espalexaUdp.parsePacket();
+      if (!packetSize) return; //no new udp packet
+      
+      EA_DEBUGLN("Got UDP!");
+      int len = espalexaUdp.read(packetBuffer, sizeof(packetBuffer) -1);
+      espalexaUdp.flush(); //drops the rest, the ESP32 core doesn't parse the next packet before
+      if (len <= 0) continue;
+      packetBuffer[len] = 0; //longer packets are matched on their first part
+      if (!discoverable) continue; //do not reply to M-SEARCH if not discoverable
+      
+      if (isSearchRequest(packetBuffer)) {
+        EA_DEBUGLN(packetBuffer);
+        scheduleSearchReply(espalexaUdp.remoteIP(), espalexaUdp.remotePort(), searchMx(packetBuffer));
+      }
+    }
+  }
+
+  //queue a reply at a random time within the MX window, repeated searches of the same requester inside that window share it
+  void scheduleSearchReply(IPAddress ip, uint16_t port, uint8_t mx)
+  {
+    uint32_t now = millis();
+    uint32_t window = mx * 1000UL;
+    ssdpStats.searches++;
+    SearchReply* slot = nullptr;
+    for (SearchReply& r : searchReplies)
+    {
+      bool active = r.pending || (int32_t)(r.until - now) > 0;
+      if (active && r.port == port && r.ip == ip)
+      {
+        EA_DEBUGLN("Coalescing search req");
+        ssdpStats.coalesced++;
+        return;
+      }
+      if (!active && slot == nullptr) slot = &r;
+    }
+    if (slot == nullptr) //queue full
+    {
+      ssdpStats.dropped++;
+      return;
+    }
+    slot->ip = ip;
+    slot->port = port;
+    slot->due = now + (window ? random(window) : 0);
+    slot->until = now + window;
+    slot->pending = true;
+  }
+
+  void sendSearchReplies()
+  {
+    uint32_t now = millis();
+    for (SearchReply& r : searchReplies)
+    {
+      if (!r.pending || (int32_t)(now - r.due) < 0) continue;
+      r.pending = false;
+      if (now - replyBudgetStart >= 1000)
+      {
+        replyBudgetStart = now;
+        replyBudgetUsed = 0;
+      }
+      if (replyBudgetUsed >= ESPALEXA_SSDP_REPLIES_PER_SEC)
+      {
+        ssdpStats.dropped++;
+        continue;
+      }
+      replyBudgetUsed++;
+      EA_DEBUGLN("Responding search req...");
+      respondToSearch(r.ip, r.port);
+      ssdpStats.replies++;
+    }
   }
 
 public:
@@ -328,6 +1340,10 @@ public:
     escapedMac = WiFi.macAddress();
     escapedMac.replace(":", "");
     escapedMac.toLowerCase();
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    lightIdBase = ((uint32_t)mac[3] << 20) | ((uint32_t)mac[4] << 12) | (mac[5] << 4);
+    discoveryRendered = false;
 
     #ifdef ESPALEXA_ASYNC
     serverAsync = externalServer;
@@ -352,31 +1368,26 @@ public:
 
   //service loop
   void loop() {
+    #ifndef ESPALEXA_COMMAND_QUEUE
+    #ifdef ESPALEXA_ASYNC
+    applyQueuedCommands(); //devices, callbacks and transitions are only touched here, never by the TCP task
+    #endif
+    updateDevices();
+    #endif
     #ifndef ESPALEXA_ASYNC
     if (server == nullptr) return; //only if begin() was not called
     server->handleClient();
     #endif
+    #ifndef ESPALEXA_COMMAND_QUEUE
+    if (pendingCallbackCount || pendingGroupCallbackCount) dispatchCallbacks();
+    #ifdef ESPALEXA_ASYNC
+    publishChangedStates(); //changes of Alexa commands, callbacks and the sketch since the last loop()
+    #endif
+    #endif
     
     if (!udpConnected) return;   
-    int packetSize = espalexaUdp.parsePacket();    
-    if (!packetSize) return; //no new udp packet
-    
-    EA_DEBUGLN("Got UDP!");
-    int len = espalexaUdp.read(packetBuffer, 254);
-    if (len > 0) {
-      packetBuffer[len] = 0;
-    }
-    espalexaUdp.flush();
-    if (!discoverable) return; //do not reply to M-SEARCH if not discoverable
-    
-    String request = packetBuffer;
-    if(request.indexOf("M-SEARCH") >= 0) {
-      EA_DEBUGLN(request);
-      if(request.indexOf("upnp:rootdevice") > 0 || request.indexOf("asic:1") > 0 || request.indexOf("ssdp:all") > 0) {
-        EA_DEBUGLN("Responding search req...");
-        respondToSearch();
-      }
-    }
+    receiveSearch();
+    sendSearchReplies();
   }
 
   bool addDevice(EspalexaDevice* d)
@@ -385,20 +1396,36 @@ public:
     EA_DEBUGLN((currentDeviceCount+1));
     if (currentDeviceCount >= ESPALEXA_MAXDEVICES) return false;
     if (d == nullptr) return false;
+    if (!ESPALEXA_DEVICE_LAYOUT) return false; //never happens, but the library has to be built with the same EspalexaDevice layout to link
     d->setId(currentDeviceCount);
     devices[currentDeviceCount] = d;
+    #ifdef ESPALEXA_STATE_SNAPSHOTS
+    publishState(currentDeviceCount);
+    #endif
     currentDeviceCount++;
     return true;
   }
   
+  //devices can be added to the group before or after they are added to Espalexa
+  bool addGroup(EspalexaGroup* g)
+  {
+    EA_DEBUG("Adding group ");
+    EA_DEBUGLN((currentGroupCount+1));
+    if (currentGroupCount >= ESPALEXA_MAXGROUPS) return false;
+    if (g == nullptr) return false;
+    g->setId(currentGroupCount);
+    groups[currentGroupCount] = g;
+    currentGroupCount++;
+    return true;
+  }
+  
   //brightness-only callback
   bool addDevice(String deviceName, BrightnessCallbackFunction callback, uint8_t initialValue = 0)
   {
     EA_DEBUG("Constructing device ");
     EA_DEBUGLN((currentDeviceCount+1));
     if (currentDeviceCount >= ESPALEXA_MAXDEVICES) return false;
-    EspalexaDevice* d = new EspalexaDevice(deviceName, callback, initialValue);
-    return addDevice(d);
+    return addOwnedDevice(EspalexaDevice(deviceName, callback, initialValue));
   }
   
   //brightness-only callback
@@ -407,8 +1434,7 @@ public:
     EA_DEBUG("Constructing device ");
     EA_DEBUGLN((currentDeviceCount+1));
     if (currentDeviceCount >= ESPALEXA_MAXDEVICES) return false;
-    EspalexaDevice* d = new EspalexaDevice(deviceName, callback, initialValue);
-    return addDevice(d);
+    return addOwnedDevice(EspalexaDevice(deviceName, callback, initialValue));
   }
 
 
@@ -417,142 +1443,103 @@ public:
     EA_DEBUG("Constructing device ");
     EA_DEBUGLN((currentDeviceCount+1));
     if (currentDeviceCount >= ESPALEXA_MAXDEVICES) return false;
-    EspalexaDevice* d = new EspalexaDevice(deviceName, callback, t, initialValue);
-    return addDevice(d);
+    return addOwnedDevice(EspalexaDevice(deviceName, callback, t, initialValue));
   }
   
   //basic implementation of Philips hue api functions needed for basic Alexa control
   #ifdef ESPALEXA_ASYNC
   bool handleAlexaApiCall(AsyncWebServerRequest* request)
   {
-    server = request; //copy request reference
-    String req = request->url(); //body from global variable
     EA_DEBUGLN(request->contentType());
-    if (request->hasParam("body", true)) // This is necessary, otherwise ESP crashes if there is no body
+    const char* body = (const char*)request->_tempObject; //see receiveBody()
+    size_t len = (body == nullptr) ? 0 : request->contentLength();
+    if (body == nullptr && request->hasParam("body", true)) // This is necessary, otherwise ESP crashes if there is no body
     {
       EA_DEBUG("BodyMethod2");
-      body = request->getParam("body", true)->value();
+      const String& param = request->getParam("body", true)->value();
+      body = param.c_str();
+      len = param.length();
     }
+    if (body == nullptr) body = "";
     EA_DEBUG("FinalBody: ");
     EA_DEBUGLN(body);
+    EspalexaRequest req = {request, body, len};
+    return handleApiCall(req, request->url().c_str());
+  }
   #else
-  bool handleAlexaApiCall(String req, String body)
-  {  
+  bool handleAlexaApiCall(const String& req, const String& body)
+  {
+    EspalexaRequest request = {server, body.c_str(), body.length()};
+    return handleApiCall(request, req.c_str());
+  }
   #endif
-    EA_DEBUGLN("AlexaApiCall");
-    if (req.indexOf("api") <0) return false; //return if not an API call
-    EA_DEBUGLN("ok");
 
-    if (body.indexOf("devicetype") > 0) //client wants a hue api username, we don't care and give static
+  //limit the UDP work done by one loop() call
+  void setUdpBudget(uint8_t packets, uint32_t micros)
+  {
+    udpPacketBudget = packets ? packets : 1;
+    udpTimeBudget = micros;
+  }
+  
+  EspalexaSsdpStats getSsdpStats()
+  {
+    return ssdpStats;
+  }
+
+  #ifdef ESPALEXA_COMMAND_QUEUE
+  //applies the queued Alexa commands, runs transitions and callbacks. Call this often from the task that owns the devices,
+  //loop() and the web server only touch the queue and the published device states
+  void processCommands()
+  {
+    applyQueuedCommands();
+    updateDevices();
+    publishChangedStates();
+  }
+  #endif
+
+  #ifdef ESPALEXA_COMMAND_HANDOFF
+  //commands lost because the queue was full
+  uint32_t getDroppedCommands()
+  {
+    return droppedCommands;
+  }
+  #endif
+
+  //applies state changes made by the application (e.g. a wall switch or a scene) to several devices in one pass.
+  //Each changed device gets one new version for all its changes, so cached state is rendered once.
+  //With notify, the callbacks of the changed devices are run together after all changes are applied
+  //(later if setCallbackDebounce() is used). With ESPALEXA_COMMAND_QUEUE, call this from the task that calls processCommands()
+  void applyBatch(const EspalexaUpdate* updates, uint8_t count, bool notify = false)
+  {
+    for (uint8_t i = 0; i < count; i++)
     {
-      EA_DEBUGLN("devType");
-      body = "";
-      server->send(200, "application/json", "[{\"success\":{\"username\":\"2WLEDHardQrI3WHYTHoMcXHgEspsM8ZZRpSKtBQr\"}}]");
-      return true;
+      if (isDevice(updates[i].device)) updates[i].device->beginUpdate();
     }
-
-    if (req.indexOf("state") > 0) //client wants to control light
+    for (uint8_t i = 0; i < count; i++)
     {
-      server->send(200, "application/json", "[{\"success\":{\"/lights/1/state/\": true}}]");
-
-      uint32_t devId = req.substring(req.indexOf("lights")+7).toInt();
-      EA_DEBUG("ls"); EA_DEBUGLN(devId);
-      devId = decodeLightId(devId);
-      EA_DEBUGLN(devId);
-      devId--; //zero-based for devices array
-      if (devId >= currentDeviceCount) return true; //return if invalid ID
-      
-      devices[devId]->setPropertyChanged(EspalexaDeviceProperty::none);
-      
-      if (body.indexOf("false")>0) //OFF command
-      {
-        devices[devId]->setValue(0);
-        devices[devId]->setPropertyChanged(EspalexaDeviceProperty::off);
-        devices[devId]->doCallback();
-        return true;
-      }
-      
-      if (body.indexOf("true") >0) //ON command
-      {
-        devices[devId]->setValue(devices[devId]->getLastValue());
-        devices[devId]->setPropertyChanged(EspalexaDeviceProperty::on);
-      }
-      
-      if (body.indexOf("bri")  >0) //BRIGHTNESS command
-      {
-        uint8_t briL = body.substring(body.indexOf("bri") +5).toInt();
-        if (briL == 255)
-        {
-         devices[devId]->setValue(255);
-        } else {
-         devices[devId]->setValue(briL+1); 
-        }
-        devices[devId]->setPropertyChanged(EspalexaDeviceProperty::bri);
-      }
-      
-      if (body.indexOf("xy")   >0) //COLOR command (XY mode)
-      {
-        devices[devId]->setColorXY(body.substring(body.indexOf("[") +1).toFloat(), body.substring(body.indexOf(",0") +1).toFloat());
-        devices[devId]->setPropertyChanged(EspalexaDeviceProperty::xy);
-      }
-      
-      if (body.indexOf("hue")  >0) //COLOR command (HS mode)
-      {
-        devices[devId]->setColor(body.substring(body.indexOf("hue") +5).toInt(), body.substring(body.indexOf("sat") +5).toInt());
-        devices[devId]->setPropertyChanged(EspalexaDeviceProperty::hs);
-      }
-      
-      if (body.indexOf("ct")   >0) //COLOR TEMP command (white spectrum)
-      {
-        devices[devId]->setColor(body.substring(body.indexOf("ct") +4).toInt());
-        devices[devId]->setPropertyChanged(EspalexaDeviceProperty::ct);
-      }
-      
-      devices[devId]->doCallback();
-      
-      #ifdef ESPALEXA_DEBUG
-      if (devices[devId]->getLastChangedProperty() == EspalexaDeviceProperty::none)
-        EA_DEBUGLN("STATE REQ WITHOUT BODY (likely Content-Type issue #6)");
-      #endif
-      return true;
+      if (isDevice(updates[i].device)) applyCommand(updates[i].device, updates[i].cmd, 0, notify);
     }
-    
-    int pos = req.indexOf("lights");
-    if (pos > 0) //client wants light info
+    for (uint8_t i = 0; i < count; i++)
     {
-      int devId = req.substring(pos+7).toInt();
-      EA_DEBUG("l"); EA_DEBUGLN(devId);
-
-      if (devId == 0) //client wants all lights
-      {
-        EA_DEBUGLN("lAll");
-        String jsonTemp = "{";
-        for (int i = 0; i<currentDeviceCount; i++)
-        {
-          jsonTemp += "\"" + String(encodeLightId(i+1)) + "\":";
-          jsonTemp += deviceJsonString(i+1);
-          if (i < currentDeviceCount-1) jsonTemp += ",";
-        }
-        jsonTemp += "}";
-        server->send(200, "application/json", jsonTemp);
-      } else //client wants one light (devId)
-      {
-        devId = decodeLightId(devId);
-        EA_DEBUGLN(devId);
-        if (devId > currentDeviceCount)
-        {
-          server->send(200, "application/json", "{}");
-        } else {
-          server->send(200, "application/json", deviceJsonString(devId));
-        }
-      }
-      
-      return true;
+      if (!isDevice(updates[i].device)) continue;
+      updates[i].device->endUpdate();
+      #ifdef ESPALEXA_STATE_SNAPSHOTS
+      uint8_t slot = updates[i].device->getId();
+      if (stateSnapshotVersion[slot] != devices[slot]->getVersion()) publishState(slot);
+      #endif
     }
+    if (notify && pendingCallbackCount) dispatchCallbacks();
+  }
 
-    //we don't care about other api commands at this time and send empty JSON
-    server->send(200, "application/json", "{}");
-    return true;
+  //time in ms device callbacks are held back to merge further changes, 0 runs them on the next loop()
+  void setCallbackDebounce(uint32_t ms)
+  {
+    callbackDebounce = ms;
+  }
+
+  EspalexaCallbackStats getCallbackStats()
+  {
+    return callbackStats;
   }
   
   //set whether Alexa can discover any devices
@@ -568,6 +1555,21 @@ public:
     return devices[index];
   }
   
+  //get EspalexaGroup at specific index (the Hue group ID is index+1)
+  EspalexaGroup* getGroup(uint8_t index)
+  {
+    if (index >= currentGroupCount) return nullptr;
+    return groups[index];
+  }
+  
+  //get EspalexaDevice by its Hue light ID or uniqueid (as used in the API URLs)
+  EspalexaDevice* getDeviceByLightId(uint32_t id)
+  {
+    int idx = lightIndex(id);
+    if (idx < 0) return nullptr;
+    return devices[idx];
+  }
+  
   //is an unique device ID
   String getEscapedMac()
   {
@@ -581,7 +1583,15 @@ public:
     return perc / 255;
   }
   
-  ~Espalexa(){delete devices;} //note: Espalexa is NOT meant to be destructed
+  ~Espalexa() //note: Espalexa is NOT meant to be destructed
+  {
+    #ifndef ESPALEXA_STATIC_DEVICES
+    for (uint8_t i = 0; i < currentDeviceCount; i++)
+    {
+      if (ownedDevices[i]) delete devices[i];
+    }
+    #endif
+  }
 };
 
 #endif
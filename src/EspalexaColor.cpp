@@ -0,0 +1,232 @@
+//EspalexaColor Class
+
+#include "EspalexaColor.h"
+
+//Green and blue for 20-65 (10000/mired, the CT_MIN-CT_MAX range). Red is always 255.
+//Generated with the formulas of https://gist.github.com/paulkaplan/5184275 that getRGB() used before:
+//g = 99.470802 * log(t) - 161.119568, b = 138.517731 * log(t-10) - 305.044793, truncated to 0-255
+static const uint8_t ctTable[][2] PROGMEM = {
+  {136,13}, {141,27}, {146,39}, {150,50}, {155,60}, {159,70}, {162,79}, {166,87},
+  {170,95}, {173,102}, {177,109}, {180,116}, {183,123}, {186,129}, {189,135}, {192,140},
+  {195,146}, {198,151}, {200,156}, {203,161}, {205,166}, {208,170}, {210,175}, {213,179},
+  {215,183}, {217,187}, {219,191}, {221,195}, {223,198}, {226,202}, {228,205}, {229,209},
+  {231,212}, {233,215}, {235,219}, {237,222}, {239,225}, {241,228}, {242,231}, {244,234},
+  {246,236}, {247,239}, {249,242}, {251,244}, {252,247}, {254,250},
+};
+
+//Smallest linear value (0-65535) that encodes to each 8 bit sRGB level,
+//i.e. the inverse of 255 * (1.055 * pow(v, 1/2.4) - 0.055), or 255 * 12.92 * v below 0.0031308
+static const uint16_t gammaTable[256] PROGMEM = {
+  0, 20, 40, 60, 80, 100, 120, 140, 160, 180, 199, 220, 241, 264, 288, 314,
+  340, 368, 397, 427, 459, 492, 526, 562, 599, 638, 677, 719, 762, 806, 851, 898,
+  947, 997, 1049, 1102, 1157, 1213, 1271, 1330, 1391, 1454, 1518, 1584, 1651, 1720, 1791, 1863,
+  1938, 2013, 2091, 2170, 2251, 2334, 2418, 2504, 2592, 2682, 2773, 2867, 2962, 3059, 3157, 3258,
+  3360, 3465, 3571, 3679, 3789, 3901, 4014, 4130, 4247, 4367, 4488, 4612, 4737, 4864, 4993, 5125,
+  5258, 5393, 5530, 5669, 5811, 5954, 6099, 6246, 6396, 6547, 6701, 6857, 7014, 7174, 7336, 7500,
+  7666, 7834, 8005, 8177, 8352, 8529, 8708, 8889, 9073, 9258, 9446, 9636, 9828, 10023, 10219, 10418,
+  10619, 10822, 11028, 11236, 11446, 11658, 11873, 12090, 12309, 12531, 12755, 12981, 13209, 13440, 13674, 13909,
+  14147, 14387, 14630, 14875, 15122, 15372, 15624, 15878, 16135, 16395, 16656, 16921, 17187, 17456, 17728, 18001,
+  18278, 18557, 18838, 19122, 19408, 19697, 19988, 20282, 20578, 20876, 21178, 21481, 21788, 22097, 22408, 22722,
+  23038, 23357, 23679, 24003, 24330, 24659, 24991, 25325, 25662, 26002, 26344, 26689, 27036, 27387, 27739, 28095,
+  28453, 28813, 29177, 29543, 29911, 30283, 30657, 31033, 31413, 31795, 32180, 32567, 32957, 33350, 33746, 34144,
+  34545, 34949, 35355, 35765, 36177, 36591, 37009, 37429, 37852, 38278, 38707, 39138, 39572, 40009, 40449, 40892,
+  41337, 41785, 42236, 42690, 43147, 43607, 44069, 44534, 45002, 45473, 45947, 46424, 46903, 47386, 47871, 48359,
+  48851, 49345, 49841, 50341, 50844, 51350, 51858, 52370, 52884, 53401, 53922, 54445, 54971, 55500, 56032, 56568,
+  57106, 57647, 58191, 58738, 59287, 59840, 60396, 60955, 61517, 62082, 62650, 63221, 63795, 64372, 64952, 65535
+};
+
+//The per pixel conversions are inline and shared by the single color and the batch functions.
+//Only hsPixel() is branch free, so the hs batch loop can be vectorized by the compiler. xy and ct stay scalar.
+
+static inline uint32_t ctPixel(uint16_t ct)
+{
+  // Cold white to warm white receiving from Alexa: ct = 199, 234, 284, 350, 383 (from cold white to warm white)
+  switch (ct) {
+    case 199: return 0xFFFFFFFF;
+    case 234: return 0xFF7F7F7F;
+    case 284: return 0xFF000000;
+    case 350: return 0xFF825A00;
+    case 383: return 0xFFFF9900;
+  }
+  if (ct < EspalexaColor::CT_MIN) ct = EspalexaColor::CT_MIN;
+  if (ct > EspalexaColor::CT_MAX) ct = EspalexaColor::CT_MAX;
+  uint8_t i = 10000 / ct - 10000 / EspalexaColor::CT_MAX;
+  return 0xFF0000 | (pgm_read_byte(&ctTable[i][0]) << 8) | pgm_read_byte(&ctTable[i][1]);
+}
+
+static inline uint8_t gammaPixel(uint16_t linear)
+{
+  //binary search for the highest level whose threshold is not above the input
+  uint8_t level = 0;
+  for (uint8_t step = 128; step; step >>= 1)
+  {
+    if (pgm_read_word(&gammaTable[level + step]) <= linear) level += step;
+  }
+  return level;
+}
+
+//one channel of hue (h6 is hue * 6, one sextant is 65535) and saturation, n is 5 for red, 3 for green and 1 for blue
+static inline uint32_t hsChannel(uint32_t h6, uint32_t sat, uint32_t n)
+{
+  uint32_t k = n * 65535 + h6;
+  k = (k >= 6 * 65535UL) ? k - 6 * 65535UL : k;
+  int32_t f = 4 * 65535L - (int32_t)k;
+  f = ((int32_t)k < f) ? (int32_t)k : f;
+  f = (f < 0) ? 0 : (f > 65535) ? 65535 : f;
+  uint32_t v = 255UL * 65535 - (uint32_t)f * sat;
+  return (v + 1 + (v >> 16)) >> 16; //v / 65535
+}
+
+static inline uint32_t hsPixel(uint16_t hue, uint8_t sat)
+{
+  uint32_t h6 = (uint32_t)hue * 6;
+  return (hsChannel(h6, sat, 5) << 16) | (hsChannel(h6, sat, 3) << 8) | hsChannel(h6, sat, 1);
+}
+
+//Conversion constants of a gamut, see EspalexaGamut.
+//Hue lamps all use the wide gamut matrices from https://www.developers.meethue.com/documentation/color-conversions-rgb-xy
+//and clamp colors to the triangle of their primaries, sRGB uses its own primaries and D65 white
+struct GamutProfile {
+  int16_t toRgb[9];     //XYZ to linear RGB in 1/4096 steps
+  uint16_t toXyz[9];    //linear RGB to XYZ in 1/65536 steps
+  uint16_t triangle[6]; //xy of the red, green and blue primaries (counterclockwise), all 0 if colors are not clamped
+};
+
+#define HUE_WIDE_TO_RGB {6785, -1453, -1045, -2897, 6781, 148, 212, -497, 4143}
+#define HUE_WIDE_TO_XYZ {43549, 10114, 10619, 18604, 43806, 3125, 6, 4739, 64621}
+
+static constexpr GamutProfile gamuts[] = {
+  {HUE_WIDE_TO_RGB, HUE_WIDE_TO_XYZ, {0, 0, 0, 0, 0, 0}},                         //wide
+  {HUE_WIDE_TO_RGB, HUE_WIDE_TO_XYZ, {46137, 19398, 14097, 46569, 9044, 5243}},   //A
+  {HUE_WIDE_TO_RGB, HUE_WIDE_TO_XYZ, {44236, 21102, 26804, 33947, 10944, 2621}},  //B
+  {HUE_WIDE_TO_RGB, HUE_WIDE_TO_XYZ, {45350, 20185, 11141, 45874, 10027, 3146}},  //C
+  {{13273, -6296, -2042, -3969, 7683, 170, 228, -836, 4329},
+   {27027, 23436, 11829, 13933, 46871, 4732, 1265, 7812, 62292},
+   {41942, 21627, 19661, 39321, 9830, 3932}}                                     //srgb
+};
+
+//which side of the edge a-b the point p is on, negative is outside
+static inline int64_t edgeSide(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t px, int32_t py)
+{
+  return (int64_t)(bx - ax) * (py - ay) - (int64_t)(by - ay) * (px - ax);
+}
+
+//moves xy outside of the gamut triangle to the closest point on its border
+static inline void clampPixel(uint16_t& x, uint16_t& y, const GamutProfile& g)
+{
+  const uint16_t* t = g.triangle;
+  if (t[0] == 0) return;
+  int64_t best = -1;
+  int32_t bestX = x, bestY = y;
+  for (uint8_t e = 0; e < 3; e++)
+  {
+    int32_t ax = t[e*2], ay = t[e*2+1];
+    int32_t bx = t[(e*2+2) % 6], by = t[(e*2+3) % 6];
+    if (edgeSide(ax, ay, bx, by, x, y) >= 0) continue;
+    int64_t dx = bx - ax, dy = by - ay;
+    int64_t num = dx * (x - ax) + dy * (y - ay);
+    int64_t den = dx * dx + dy * dy;
+    int32_t cx = ax, cy = ay;
+    if (num >= den) {cx = bx; cy = by;}
+    else if (num > 0) {cx = ax + dx * num / den; cy = ay + dy * num / den;}
+    int64_t d = (int64_t)(cx - x) * (cx - x) + (int64_t)(cy - y) * (cy - y);
+    if (best < 0 || d < best) {best = d; bestX = cx; bestY = cy;}
+  }
+  x = bestX; y = bestY;
+}
+
+static inline uint32_t xyPixel(uint16_t x, uint16_t y, const GamutProfile& g)
+{
+  clampPixel(x, y, g);
+  //XYZ with Y = 1 would be x/y, 1, z/y. The common factor 1/y cancels out when scaling to the brightest channel below
+  int32_t z = (int32_t)EspalexaColor::XY_ONE - x - y;
+  const int16_t* m = g.toRgb;
+  //shifted down to 15-16 bits so the scaling can't overflow
+  int32_t r = ((int32_t)x * m[0] + (int32_t)y * m[1] + z * m[2]) >> 14;
+  int32_t gr = ((int32_t)x * m[3] + (int32_t)y * m[4] + z * m[5]) >> 14;
+  int32_t b = ((int32_t)x * m[6] + (int32_t)y * m[7] + z * m[8]) >> 14;
+  int32_t mx = r > gr ? r : gr;
+  if (b > mx) mx = b;
+  if (mx <= 0) return 0;
+  //out of gamut values are clipped
+  uint32_t lr = r > 0 ? (uint32_t)r * EspalexaColor::XY_ONE / mx : 0;
+  uint32_t lg = gr > 0 ? (uint32_t)gr * EspalexaColor::XY_ONE / mx : 0;
+  uint32_t lb = b > 0 ? (uint32_t)b * EspalexaColor::XY_ONE / mx : 0;
+  return (gammaPixel(lr) << 16) | (gammaPixel(lg) << 8) | gammaPixel(lb);
+}
+
+static inline bool rgbToXyPixel(uint8_t r, uint8_t g, uint8_t b, uint16_t& x, uint16_t& y, const GamutProfile& p)
+{
+  const uint16_t* m = p.toXyz;
+  uint32_t X = r * (uint32_t)m[0] + g * (uint32_t)m[1] + b * (uint32_t)m[2];
+  uint32_t Y = r * (uint32_t)m[3] + g * (uint32_t)m[4] + b * (uint32_t)m[5];
+  uint32_t Z = r * (uint32_t)m[6] + g * (uint32_t)m[7] + b * (uint32_t)m[8];
+  uint32_t sum = X + Y + Z;
+  if (sum == 0) return false;
+  x = (uint64_t)X * EspalexaColor::XY_ONE / sum;
+  y = (uint64_t)Y * EspalexaColor::XY_ONE / sum;
+  clampPixel(x, y, p);
+  return true;
+}
+
+//the gamut is a template parameter, so its constants end up as immediates instead of table reads
+template <uint8_t G> static void xyBatch(const uint16_t* __restrict x, const uint16_t* __restrict y, uint32_t* __restrict rgb, size_t count)
+{
+  for (size_t i = 0; i < count; i++) rgb[i] = xyPixel(x[i], y[i], gamuts[G]);
+}
+
+uint32_t EspalexaColor::ct(uint16_t ct)
+{
+  return ctPixel(ct);
+}
+
+uint8_t EspalexaColor::gamma(uint16_t linear)
+{
+  return gammaPixel(linear);
+}
+
+uint32_t EspalexaColor::hs(uint16_t hue, uint8_t sat)
+{
+  return hsPixel(hue, sat);
+}
+
+uint32_t EspalexaColor::xy(uint16_t x, uint16_t y, EspalexaGamut gamut)
+{
+  uint32_t rgb;
+  xy(&x, &y, &rgb, 1, gamut);
+  return rgb;
+}
+
+void EspalexaColor::ct(const uint16_t* __restrict ct, uint32_t* __restrict rgb, size_t count)
+{
+  for (size_t i = 0; i < count; i++) rgb[i] = ctPixel(ct[i]);
+}
+
+void EspalexaColor::hs(const uint16_t* __restrict hue, const uint8_t* __restrict sat, uint32_t* __restrict rgb, size_t count)
+{
+  for (size_t i = 0; i < count; i++) rgb[i] = hsPixel(hue[i], sat[i]);
+}
+
+void EspalexaColor::xy(const uint16_t* x, const uint16_t* y, uint32_t* rgb, size_t count, EspalexaGamut gamut)
+{
+  switch (gamut)
+  {
+    case EspalexaGamut::A:    xyBatch<1>(x, y, rgb, count); break;
+    case EspalexaGamut::B:    xyBatch<2>(x, y, rgb, count); break;
+    case EspalexaGamut::C:    xyBatch<3>(x, y, rgb, count); break;
+    case EspalexaGamut::srgb: xyBatch<4>(x, y, rgb, count); break;
+    default:                  xyBatch<0>(x, y, rgb, count);
+  }
+}
+
+bool EspalexaColor::rgbToXy(uint8_t r, uint8_t g, uint8_t b, uint16_t& x, uint16_t& y, EspalexaGamut gamut)
+{
+  switch (gamut)
+  {
+    case EspalexaGamut::A:    return rgbToXyPixel(r, g, b, x, y, gamuts[1]);
+    case EspalexaGamut::B:    return rgbToXyPixel(r, g, b, x, y, gamuts[2]);
+    case EspalexaGamut::C:    return rgbToXyPixel(r, g, b, x, y, gamuts[3]);
+    case EspalexaGamut::srgb: return rgbToXyPixel(r, g, b, x, y, gamuts[4]);
+    default:                  return rgbToXyPixel(r, g, b, x, y, gamuts[0]);
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef EspalexaColor_h
+#define EspalexaColor_h
+
+#include "Arduino.h"
+
+//Color gamut of the light, used for the conversions between xy and RGB.
+//wide: what Espalexa always used, Hue matrices without clamping. A, B, C: Hue lamp gamuts
+//(e.g. A: LivingColors, B: first Hue bulbs, C: current Hue bulbs), srgb: typical RGB LED strips
+enum class EspalexaGamut : uint8_t { wide = 0, A = 1, B = 2, C = 3, srgb = 4 };
+
+//Integer only color conversions, used by EspalexaDevice and usable on their own.
+//Colors are packed like getRGB(): 0xWWRRGGBB. CIE xy coordinates are fixed point, 0-65535 is 0.0-1.0
+class EspalexaColor {
+public:
+  static const uint16_t CT_MIN = 153; //Hue color temperature range in mired
+  static const uint16_t CT_MAX = 500;
+  static const uint16_t XY_ONE = 65535;
+
+  //hue 0-65535, saturation 0-255 to RGB
+  static uint32_t hs(uint16_t hue, uint8_t sat);
+
+  //CIE xy to RGB, colors outside of the gamut are moved to its border
+  static uint32_t xy(uint16_t x, uint16_t y, EspalexaGamut gamut = EspalexaGamut::wide);
+
+  //RGB to CIE xy, returns false (and leaves x and y alone) for black
+  static bool rgbToXy(uint8_t r, uint8_t g, uint8_t b, uint16_t& x, uint16_t& y, EspalexaGamut gamut = EspalexaGamut::wide);
+
+  //color temperature in mired (clamped to CT_MIN-CT_MAX) to RGB
+  static uint32_t ct(uint16_t ct);
+
+  //sRGB gamma encoding, linear 0-65535 (0.0-1.0) to 0-255
+  static uint8_t gamma(uint16_t linear);
+
+  //batch versions for many pixels (e.g. LED strip segments), inputs and output are separate arrays of count elements
+  static void ct(const uint16_t* ct, uint32_t* rgb, size_t count);
+  static void hs(const uint16_t* hue, const uint8_t* sat, uint32_t* rgb, size_t count);
+  static void xy(const uint16_t* x, const uint16_t* y, uint32_t* rgb, size_t count, EspalexaGamut gamut = EspalexaGamut::wide);
+};
+
+#endif
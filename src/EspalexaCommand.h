@@ -0,0 +1,193 @@
+#ifndef EspalexaCommand_h
+#define EspalexaCommand_h
+
+#include "Arduino.h"
+
+enum class EspalexaCommandField : uint8_t { on = 1, bri = 2, hue = 4, sat = 8, xy = 16, ct = 32, transitiontime = 64 };
+
+//Hue light state change (the body of a PUT /lights/<id>/state request)
+class EspalexaCommand {
+private:
+  const char* _p;
+  const char* _end;
+
+  void skipSpace()
+  {
+    while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r' || *_p == '\n')) _p++;
+  }
+
+  bool expect(char c)
+  {
+    skipSpace();
+    if (_p >= _end || *_p != c) return false;
+    _p++;
+    return true;
+  }
+
+  bool isKey(const char* key, size_t len, const char* name)
+  {
+    size_t i = 0;
+    for (; i < len; i++) if (name[i] != key[i]) return false; //stops at the terminator of name
+    return name[i] == 0;
+  }
+
+  bool parseBool(bool& v)
+  {
+    if (_end - _p >= 4 && !memcmp(_p, "true", 4))  {_p += 4; v = true;  return true;}
+    if (_end - _p >= 5 && !memcmp(_p, "false", 5)) {_p += 5; v = false; return true;}
+    return false;
+  }
+
+  //integer part of a number, clamped to [0, max]. Fraction and exponent are skipped like toInt() does
+  bool parseUint(uint16_t& v, uint16_t max)
+  {
+    bool neg = (_p < _end && *_p == '-');
+    if (neg) _p++;
+    if (_p >= _end || *_p < '0' || *_p > '9') return false;
+    uint32_t n = 0;
+    for (; _p < _end && *_p >= '0' && *_p <= '9'; _p++) if (n <= max) n = n*10 + (*_p - '0');
+    skipNumberTail();
+    v = neg ? 0 : (n > max ? max : n);
+    return true;
+  }
+
+  //0.0-1.0 to 0-65535 without floating point math, out of range values are clipped
+  bool parseFixed(uint16_t& v)
+  {
+    bool neg = (_p < _end && *_p == '-');
+    if (neg) _p++;
+    if (_p >= _end || *_p < '0' || *_p > '9') return false;
+    uint32_t n = 0, div = 1;
+    for (; _p < _end && *_p >= '0' && *_p <= '9'; _p++) if (n < 2) n = n*10 + (*_p - '0');
+    n = (n > 1) ? 100000 : n * 100000;
+    if (_p < _end && *_p == '.')
+    {
+      uint32_t f = 0;
+      for (_p++; _p < _end && *_p >= '0' && *_p <= '9'; _p++) if (div < 100000) {f = f*10 + (*_p - '0'); div *= 10;}
+      n += f * (100000 / div);
+    }
+    skipNumberTail();
+    if (neg) n = 0;
+    v = (n >= 100000) ? 65535 : (n * 13107 + 10000) / 20000; //n * 65535 / 100000, reduced so it fits 32 bits
+    return true;
+  }
+
+  void skipNumberTail()
+  {
+    while (_p < _end && ((*_p >= '0' && *_p <= '9') || *_p == '.' || *_p == 'e' || *_p == 'E' || *_p == '+' || *_p == '-')) _p++;
+  }
+
+  //skip any JSON value we don't care about, including nested objects and arrays
+  bool skipValue()
+  {
+    uint8_t depth = 0;
+    while (_p < _end)
+    {
+      char c = *_p++;
+      if (c == '"')
+      {
+        while (_p < _end && *_p != '"') {if (*_p == '\\') _p++; _p++;}
+        if (_p >= _end) return false;
+        _p++;
+      }
+      else if (c == '{' || c == '[') depth++;
+      else if (c == '}' || c == ']') {if (depth == 0) {_p--; return true;} depth--;}
+      else if (c == ',' && depth == 0) {_p--; return true;}
+      if (depth == 0 && (c == '"' || c == '}' || c == ']')) return true;
+    }
+    return depth == 0;
+  }
+
+  bool parseValue(const char* key, size_t len)
+  {
+    uint16_t n;
+    if (isKey(key, len, "on"))
+    {
+      if (!parseBool(on)) return false;
+      set(EspalexaCommandField::on);
+    } else if (isKey(key, len, "bri"))
+    {
+      if (!parseUint(n, 255)) return false;
+      bri = n; set(EspalexaCommandField::bri);
+    } else if (isKey(key, len, "hue"))
+    {
+      if (!parseUint(hue, 65535)) return false;
+      set(EspalexaCommandField::hue);
+    } else if (isKey(key, len, "sat"))
+    {
+      if (!parseUint(n, 255)) return false;
+      sat = n; set(EspalexaCommandField::sat);
+    } else if (isKey(key, len, "ct"))
+    {
+      if (!parseUint(ct, 65535)) return false;
+      set(EspalexaCommandField::ct);
+    } else if (isKey(key, len, "transitiontime"))
+    {
+      if (!parseUint(transitiontime, 65535)) return false;
+      set(EspalexaCommandField::transitiontime);
+    } else if (isKey(key, len, "xy"))
+    {
+      if (!expect('[')) return false;
+      skipSpace();
+      if (!parseFixed(x)) return false;
+      if (!expect(',')) return false;
+      skipSpace();
+      if (!parseFixed(y)) return false;
+      if (!expect(']')) return false;
+      set(EspalexaCommandField::xy);
+    } else return skipValue();
+    return true;
+  }
+
+  void set(EspalexaCommandField f)
+  {
+    fields |= static_cast<uint8_t>(f);
+  }
+
+public:
+  uint8_t fields = 0; //EspalexaCommandField bits present in the body
+  bool on = false;
+  uint8_t bri = 0;
+  uint8_t sat = 0;
+  uint16_t hue = 0;
+  uint16_t ct = 0;
+  uint16_t transitiontime = 0; //in 100ms steps
+  uint16_t x = 0, y = 0; //0-65535 is 0.0-1.0
+
+  bool has(EspalexaCommandField f) const
+  {
+    return fields & static_cast<uint8_t>(f);
+  }
+
+  //build a command in code instead of parsing it, the values are the same as in the Hue API
+  EspalexaCommand& setOn(bool v)                    {on = v; set(EspalexaCommandField::on); return *this;}
+  EspalexaCommand& setBri(uint8_t v)                {bri = v; set(EspalexaCommandField::bri); return *this;} //Hue brightness 0-254, the device value becomes bri+1
+  EspalexaCommand& setHueSat(uint16_t h, uint8_t s) {hue = h; sat = s; set(EspalexaCommandField::hue); set(EspalexaCommandField::sat); return *this;}
+  EspalexaCommand& setXY(uint16_t vx, uint16_t vy)  {x = vx; y = vy; set(EspalexaCommandField::xy); return *this;} //0-65535 is 0.0-1.0
+  EspalexaCommand& setCt(uint16_t v)                {ct = v; set(EspalexaCommandField::ct); return *this;}
+  EspalexaCommand& setTransitionTime(uint16_t v)    {transitiontime = v; set(EspalexaCommandField::transitiontime); return *this;} //in 100ms steps
+
+  //single pass over the state object, no allocations. Fields found before a syntax error are kept
+  bool parse(const char* body, size_t len)
+  {
+    fields = 0;
+    _p = body; _end = body + len;
+    if (!expect('{')) return false;
+    skipSpace();
+    if (_p < _end && *_p == '}') return true;
+    do {
+      if (!expect('"')) return false;
+      const char* key = _p;
+      while (_p < _end && *_p != '"') _p++;
+      if (_p >= _end) return false;
+      size_t keyLen = _p - key;
+      _p++;
+      if (!expect(':')) return false;
+      skipSpace();
+      if (!parseValue(key, keyLen)) return false;
+    } while (expect(','));
+    return expect('}');
+  }
+};
+
+#endif
@@ -2,12 +2,17 @@
 
 #include "EspalexaDevice.h"
 
+static uint32_t conversions = 0;
+
+const uint8_t ESPALEXA_DEVICE_LAYOUT = 1; //see EspalexaDevice.h
+
 EspalexaDevice::EspalexaDevice(){}
 
 EspalexaDevice::EspalexaDevice(String deviceName, BrightnessCallbackFunction gnCallback, uint8_t initialValue) { //constructor for dimmable device
   
-  _deviceName = deviceName;
-  _callback = gnCallback;
+  storeName(deviceName.c_str());
+  _callback.brightness = gnCallback;
+  _callbackType = CallbackType::brightness;
   _val = initialValue;
   _val_last = _val;
   _type = EspalexaDeviceType::dimmable;
@@ -15,8 +20,9 @@ EspalexaDevice::EspalexaDevice(String deviceName, BrightnessCallbackFunction gnC
 
 EspalexaDevice::EspalexaDevice(String deviceName, ColorCallbackFunction gnCallback, uint8_t initialValue) { //constructor for color device
   
-  _deviceName = deviceName;
-  _callbackCol = gnCallback;
+  storeName(deviceName.c_str());
+  _callback.color = gnCallback;
+  _callbackType = CallbackType::color;
   _val = initialValue;
   _val_last = _val;
   _type = EspalexaDeviceType::extendedcolor;
@@ -24,8 +30,9 @@ EspalexaDevice::EspalexaDevice(String deviceName, ColorCallbackFunction gnCallba
 
 EspalexaDevice::EspalexaDevice(String deviceName, DeviceCallbackFunction gnCallback, EspalexaDeviceType t, uint8_t initialValue) { //constructor for general device
   
-  _deviceName = deviceName;
-  _callbackDev = gnCallback;
+  storeName(deviceName.c_str());
+  _callback.device = gnCallback;
+  _callbackType = CallbackType::device;
   _type = t;
   if (t == EspalexaDeviceType::onoff) _type = EspalexaDeviceType::dimmable; //on/off is broken, so make dimmable device instead
   _val = initialValue;
@@ -49,16 +56,50 @@ EspalexaDeviceType EspalexaDevice::getType()
   return _type;
 }
 
+EspalexaGamut EspalexaDevice::getGamut()
+{
+  return _gamut;
+}
+
+uint16_t EspalexaDevice::getVersion()
+{
+  return _version;
+}
+
+uint32_t EspalexaDevice::getConversionCount()
+{
+  return conversions;
+}
+
 String EspalexaDevice::getName()
 {
   return _deviceName;
 }
 
+const char* EspalexaDevice::getNameCStr()
+{
+  #ifdef ESPALEXA_STATIC_DEVICES
+  return _deviceName;
+  #else
+  return _deviceName.c_str();
+  #endif
+}
+
 EspalexaDeviceProperty EspalexaDevice::getLastChangedProperty()
 {
   return _changed;
 }
 
+uint8_t EspalexaDevice::getChangedProperties()
+{
+  return _changedMask;
+}
+
+bool EspalexaDevice::hasChanged(EspalexaDeviceProperty p)
+{
+  return _changedMask & (1 << static_cast<uint8_t>(p));
+}
+
 uint8_t EspalexaDevice::getValue()
 {
   return _val;
@@ -85,12 +126,30 @@ uint8_t EspalexaDevice::getSat()
   return _sat;
 }
 
+//0.0-1.0 to 0-65535, out of range values are clipped
+static uint16_t toFixed(float v)
+{
+  if (v <= 0.0f) return 0;
+  if (v >= 1.0f) return EspalexaColor::XY_ONE;
+  return v * EspalexaColor::XY_ONE + 0.5f;
+}
+
 float EspalexaDevice::getX()
 {
-  return _x;
+  return (float)_x / EspalexaColor::XY_ONE;
 }
 
 float EspalexaDevice::getY()
+{
+  return (float)_y / EspalexaColor::XY_ONE;
+}
+
+uint16_t EspalexaDevice::getXFixed()
+{
+  return _x;
+}
+
+uint16_t EspalexaDevice::getYFixed()
 {
   return _y;
 }
@@ -109,124 +168,24 @@ uint32_t EspalexaDevice::getKelvin()
 
 uint32_t EspalexaDevice::getRGB()
 {
-  if (_rgb != 0) return _rgb; //color has not changed
-  byte rgb[4]{0, 0, 0, 0}; 
-  float r, g, b, w;
-  
-  if (_mode == EspalexaColorMode::none) return 0;
+  if (_rgbValid) return _rgb; //color has not changed
+  #ifdef ESPALEXA_DEBUG
+  conversions++;
+  #endif
 
+  _rgb = 0;
   if (_mode == EspalexaColorMode::ct)
   {
     //TODO tweak a bit to match hue lamp characteristics
-    //based on https://gist.github.com/paulkaplan/5184275
-    float temp = 10000/ _ct; //kelvins = 1,000,000/mired (and that /100)
-    float r, g, b;
-
-// Cold white to warm white receiving from Alexa: _ct = 199, 234, 284, 350, 383 (from cold white to warm white)
-    switch (_ct) {
-      case 199: rgb[0]=255,rgb[1]=255,rgb[2]=255;rgb[3]=255;break;
-      case 234: rgb[0]=127,rgb[1]=127,rgb[2]=127;rgb[3]=255;break;
-      case 284: rgb[0]=0,rgb[1]=0,rgb[2]=0;rgb[3]=255;break;
-      case 350: rgb[0]=130,rgb[1]=90,rgb[2]=0;rgb[3]=255;break;
-      case 383: rgb[0]=255,rgb[1]=153,rgb[2]=0;rgb[3]=255;break;
-      default: {
-        if( temp <= 66 ){ 
-          r = 255; 
-          g = temp;
-          g = 99.470802 * log(g) - 161.119568;
-          if( temp <= 19){
-              b = 0;
-          } else {
-              b = temp-10;
-              b = 138.517731 * log(b) - 305.044793;
-          }
-        } else {
-          r = temp - 60;
-          r = 329.698727 * pow(r, -0.13320476);
-          g = temp - 60;
-          g = 288.12217 * pow(g, -0.07551485 );
-          b = 255;
-        }
-    
-        rgb[0] = (byte)constrain(r,0.1,255.1);
-        rgb[1] = (byte)constrain(g,0.1,255.1);
-        rgb[2] = (byte)constrain(b,0.1,255.1);
-      }
-    }
+    _rgb = EspalexaColor::ct(_ct); //white value is 255 for the color temperatures Alexa sends
   } else if (_mode == EspalexaColorMode::hs)
   {
-    float h = ((float)_hue)/65535.0;
-    float s = ((float)_sat)/255.0;
-    byte i = floor(h*6);
-    float f = h * 6-i;
-    float p = 255 * (1-s);
-    float q = 255 * (1-f*s);
-    float t = 255 * (1-(1-f)*s);
-    switch (i%6) {
-      case 0: rgb[0]=255,rgb[1]=t,rgb[2]=p;break;
-      case 1: rgb[0]=q,rgb[1]=255,rgb[2]=p;break;
-      case 2: rgb[0]=p,rgb[1]=255,rgb[2]=t;break;
-      case 3: rgb[0]=p,rgb[1]=q,rgb[2]=255;break;
-      case 4: rgb[0]=t,rgb[1]=p,rgb[2]=255;break;
-      case 5: rgb[0]=255,rgb[1]=p,rgb[2]=q;
-    }
+    _rgb = EspalexaColor::hs(_hue, _sat);
   } else if (_mode == EspalexaColorMode::xy)
   {
-    //Source: https://www.developers.meethue.com/documentation/color-conversions-rgb-xy
-    float z = 1.0f - _x - _y;
-    float X = (1.0f / _y) * _x;
-    float Z = (1.0f / _y) * z;
-    float r = (int)255*(X * 1.656492f - 0.354851f - Z * 0.255038f);
-    float g = (int)255*(-X * 0.707196f + 1.655397f + Z * 0.036152f);
-    float b = (int)255*(X * 0.051713f - 0.121364f + Z * 1.011530f);
-    if (r > b && r > g && r > 1.0f) {
-      // red is too big
-      g = g / r;
-      b = b / r;
-      r = 1.0f;
-    } else if (g > b && g > r && g > 1.0f) {
-      // green is too big
-      r = r / g;
-      b = b / g;
-      g = 1.0f;
-    } else if (b > r && b > g && b > 1.0f) {
-      // blue is too big
-      r = r / b;
-      g = g / b;
-      b = 1.0f;
-    }
-    // Apply gamma correction
-    r = r <= 0.0031308f ? 12.92f * r : (1.0f + 0.055f) * pow(r, (1.0f / 2.4f)) - 0.055f;
-    g = g <= 0.0031308f ? 12.92f * g : (1.0f + 0.055f) * pow(g, (1.0f / 2.4f)) - 0.055f;
-    b = b <= 0.0031308f ? 12.92f * b : (1.0f + 0.055f) * pow(b, (1.0f / 2.4f)) - 0.055f;
-
-    if (r > b && r > g) {
-      // red is biggest
-      if (r > 1.0f) {
-        g = g / r;
-        b = b / r;
-        r = 1.0f;
-      }
-    } else if (g > b && g > r) {
-      // green is biggest
-      if (g > 1.0f) {
-        r = r / g;
-        b = b / g;
-        g = 1.0f;
-      }
-    } else if (b > r && b > g) {
-      // blue is biggest
-      if (b > 1.0f) {
-        r = r / b;
-        g = g / b;
-        b = 1.0f;
-      }
-    }
-    rgb[0] = 255.0*r;
-    rgb[1] = 255.0*g;
-    rgb[2] = 255.0*b;
+    _rgb = EspalexaColor::xy(getXFixed(), getYFixed(), _gamut);
   }
-  _rgb = ((rgb[3] << 24) | (rgb[0] << 16) | (rgb[1] << 8) | (rgb[2]));  //white value is only >0 if Alexa did provide a CT value, RGB colors will not be touched.
+  _rgbValid = true;
   return _rgb;
 }
 
@@ -260,6 +219,27 @@ uint8_t EspalexaDevice::getLastValue()
 void EspalexaDevice::setPropertyChanged(EspalexaDeviceProperty p)
 {
   _changed = p;
+  if (p == EspalexaDeviceProperty::none) _changedMask = 0;
+  else _changedMask |= 1 << static_cast<uint8_t>(p);
+}
+
+//all changes between beginUpdate() and endUpdate() share one new version
+void EspalexaDevice::bumpVersion()
+{
+  if (_updating) _updateChanged = true;
+  else _version++;
+}
+
+void EspalexaDevice::beginUpdate()
+{
+  _updating = true;
+}
+
+void EspalexaDevice::endUpdate()
+{
+  if (_updating && _updateChanged) _version++;
+  _updating = false;
+  _updateChanged = false;
 }
 
 void EspalexaDevice::setId(uint8_t id)
@@ -270,7 +250,32 @@ void EspalexaDevice::setId(uint8_t id)
 //you need to re-discover the device for the Alexa name to change
 void EspalexaDevice::setName(String name)
 {
+  setName(name.c_str());
+}
+
+void EspalexaDevice::setName(const char* name)
+{
+  storeName(name);
+  bumpVersion();
+}
+
+//inline names are cut to 32 UTF-8 characters and ESPALEXA_DEVICE_NAME_LEN bytes, without splitting a character
+void EspalexaDevice::storeName(const char* name)
+{
+  #ifdef ESPALEXA_STATIC_DEVICES
+  size_t len = 0;
+  for (uint8_t chars = 0; name[len] && chars < 32; chars++)
+  {
+    size_t end = len + 1;
+    while (((uint8_t)name[end] & 0xC0) == 0x80) end++; //continuation bytes
+    if (end > ESPALEXA_DEVICE_NAME_LEN) break;
+    len = end;
+  }
+  memcpy(_deviceName, name, len);
+  _deviceName[len] = 0;
+  #else
   _deviceName = name;
+  #endif
 }
 
 void EspalexaDevice::setValue(uint8_t val)
@@ -284,6 +289,7 @@ void EspalexaDevice::setValue(uint8_t val)
     _val_last = val;
   }
   _val = val;
+  bumpVersion();
 }
 
 void EspalexaDevice::setPercent(uint8_t perc)
@@ -295,42 +301,63 @@ void EspalexaDevice::setPercent(uint8_t perc)
 }
 
 void EspalexaDevice::setColorXY(float x, float y)
+{
+  setColorXYFixed(toFixed(x), toFixed(y));
+}
+
+void EspalexaDevice::setColorXYFixed(uint16_t x, uint16_t y)
 {
   _x = x;
   _y = y;
-  _rgb = 0;
+  _rgbValid = false;
   _mode = EspalexaColorMode::xy;
+  bumpVersion();
 }
 
 void EspalexaDevice::setColor(uint16_t hue, uint8_t sat)
 {
   _hue = hue;
   _sat = sat;
-  _rgb = 0;
+  _rgbValid = false;
   _mode = EspalexaColorMode::hs;
+  bumpVersion();
 }
 
 void EspalexaDevice::setColor(uint16_t ct)
 {
   _ct = ct;
-  _rgb = 0;
+  _rgbValid = false;
   _mode =EspalexaColorMode::ct;
+  bumpVersion();
 }
 
 void EspalexaDevice::setColor(uint8_t r, uint8_t g, uint8_t b)
 {
-  float X = r * 0.664511f + g * 0.154324f + b * 0.162028f;
-  float Y = r * 0.283881f + g * 0.668433f + b * 0.047685f;
-  float Z = r * 0.000088f + g * 0.072310f + b * 0.986039f;
-  _x = X / (X + Y + Z);
-  _y = Y / (X + Y + Z);
+  uint16_t x, y;
+  if (EspalexaColor::rgbToXy(r, g, b, x, y, _gamut)) //black has no chromaticity, keep the last one
+  {
+    _x = x;
+    _y = y;
+  }
   _rgb = ((r << 16) | (g << 8) | b);
+  _rgbValid = true;
   _mode = EspalexaColorMode::xy;
+  bumpVersion();
+}
+
+void EspalexaDevice::setGamut(EspalexaGamut gamut)
+{
+  _gamut = gamut;
+  _rgbValid = false;
 }
 
 void EspalexaDevice::doCallback()
 {
-  if (_callback != nullptr) {_callback(_val); return;}
-  if (_callbackDev != nullptr) {_callbackDev(this); return;}
-  if (_callbackCol != nullptr) _callbackCol(_val, getRGB());
+  switch (_callbackType)
+  {
+    case CallbackType::brightness: if (_callback.brightness != nullptr) _callback.brightness(_val); break;
+    case CallbackType::device:     if (_callback.device != nullptr) _callback.device(this); break;
+    case CallbackType::color:      if (_callback.color != nullptr) _callback.color(_val, getRGB()); break;
+    default: break;
+  }
 }
\ No newline at end of file
@@ -2,31 +2,71 @@
 #define EspalexaDevice_h
 
 #include "Arduino.h"
+#include "EspalexaColor.h"
 
-typedef class EspalexaDevice;
+class EspalexaDevice;
 
 typedef void (*BrightnessCallbackFunction) (uint8_t b);
 typedef void (*DeviceCallbackFunction) (EspalexaDevice* d);
 typedef void (*ColorCallbackFunction) (uint8_t br, uint32_t col);
 
+//With ESPALEXA_STATIC_DEVICES the name is stored in the device: up to 32 characters (the Hue limit) in ESPALEXA_DEVICE_NAME_LEN bytes.
+//Both change EspalexaDevice, so they have to be global build flags that EspalexaDevice.cpp sees as well.
+//A sketch built with other values than the library fails to link (undefined reference to espalexaDeviceLayout...)
+#ifdef ESPALEXA_STATIC_DEVICES
+ #ifndef ESPALEXA_DEVICE_NAME_LEN
+  #define ESPALEXA_DEVICE_NAME_LEN 32 //enough for 32 ASCII characters, non-ASCII characters take 2-4 bytes
+ #endif
+ #define ESPALEXA_LAYOUT_CAT(a, b) ESPALEXA_LAYOUT_CAT2(a, b)
+ #define ESPALEXA_LAYOUT_CAT2(a, b) a##b
+ #define ESPALEXA_DEVICE_LAYOUT ESPALEXA_LAYOUT_CAT(espalexaDeviceLayoutInlineName, ESPALEXA_DEVICE_NAME_LEN)
+#else
+ #define ESPALEXA_DEVICE_LAYOUT espalexaDeviceLayoutStringName
+#endif
+extern const uint8_t ESPALEXA_DEVICE_LAYOUT; //defined in EspalexaDevice.cpp, read by Espalexa::addDevice()
+
 enum class EspalexaColorMode : uint8_t { none = 0, ct = 1, hs = 2, xy = 3 };
 enum class EspalexaDeviceType : uint8_t { onoff = 0, dimmable = 1, whitespectrum = 2, color = 3, extendedcolor = 4 };
 enum class EspalexaDeviceProperty : uint8_t { none = 0, on = 1, off = 2, bri = 3, hs = 4, ct = 5, xy = 6 };
 
+//The fields are ordered by size, so there is no padding, and the ones read for every light in a /lights poll come first.
+//That is 27 bytes of state, the name and one callback pointer (see the static_assert below). On ESP8266 and ESP32 a device takes
+//48 bytes with the String name (16 bytes, longer names than 15 bytes get their own heap block) and 64 bytes with the inline name
 class EspalexaDevice {
 private:
-  String _deviceName;
-  BrightnessCallbackFunction _callback = nullptr;
-  DeviceCallbackFunction _callbackDev = nullptr;
-  ColorCallbackFunction _callbackCol = nullptr;
-  uint8_t _val, _val_last, _sat = 0;
+  enum class CallbackType : uint8_t { none = 0, brightness = 1, device = 2, color = 3 };
+  union Callback {
+    BrightnessCallbackFunction brightness;
+    DeviceCallbackFunction device;
+    ColorCallbackFunction color;
+  };
+
+  //read for every light in a poll
+  uint16_t _version = 0; //incremented on every state or name change
+  uint8_t _val = 0, _val_last = 0;
+  EspalexaDeviceType _type = EspalexaDeviceType::dimmable;
+  EspalexaColorMode _mode = EspalexaColorMode::xy;
+  uint8_t _sat = 0;
+  uint8_t _id = 0;
   uint16_t _hue = 0, _ct = 0;
-  float _x = 0.5, _y = 0.5;
+  uint16_t _x = 32768, _y = 32768; //0-65535 is 0.0-1.0
   uint32_t _rgb = 0;
-  uint8_t _id = 0;
-  EspalexaDeviceType _type;
+
+  CallbackType _callbackType = CallbackType::none;
+  EspalexaGamut _gamut = EspalexaGamut::wide;
   EspalexaDeviceProperty _changed = EspalexaDeviceProperty::none;
-  EspalexaColorMode _mode = EspalexaColorMode::xy;
+  uint8_t _changedMask = 0; //bit (1 << property) for every property changed since the last reset
+  bool _rgbValid = false; //_rgb matches the current color
+  bool _updating = false, _updateChanged = false; //see beginUpdate()
+  #ifdef ESPALEXA_STATIC_DEVICES
+  char _deviceName[ESPALEXA_DEVICE_NAME_LEN + 1] = {};
+  #else
+  String _deviceName;
+  #endif
+  Callback _callback = {nullptr}; //the member selected by _callbackType
+
+  void bumpVersion();
+  void storeName(const char* name);
   
 public:
   EspalexaDevice();
@@ -36,8 +76,11 @@ public:
   EspalexaDevice(String deviceName, ColorCallbackFunction ccb, uint8_t initialValue =0);
   
   String getName();
+  const char* getNameCStr(); //no copy, valid until the name is changed
   uint8_t getId();
   EspalexaDeviceProperty getLastChangedProperty();
+  uint8_t getChangedProperties(); //bit (1 << property) is set for every changed property
+  bool hasChanged(EspalexaDeviceProperty p);
   uint8_t getValue();
   uint8_t getPercent();
   uint8_t getDegrees();
@@ -47,6 +90,8 @@ public:
   uint32_t getKelvin();
   float getX();
   float getY();
+  uint16_t getXFixed(); //0-65535 is 0.0-1.0
+  uint16_t getYFixed();
   uint32_t getRGB();
   uint8_t getR();
   uint8_t getG();
@@ -54,20 +99,38 @@ public:
   uint8_t getW();
   EspalexaColorMode getColorMode();
   EspalexaDeviceType getType();
+  EspalexaGamut getGamut();
+  uint16_t getVersion();
+  static uint32_t getConversionCount(); //color conversions done by getRGB(), only counted if the library is built with ESPALEXA_DEBUG
   
   void setId(uint8_t id);
-  void setPropertyChanged(EspalexaDeviceProperty p);
+  void setPropertyChanged(EspalexaDeviceProperty p); //adds p to the changed properties, none clears them
   void setValue(uint8_t bri);
   void setPercent(uint8_t perc);
   void setName(String name);
+  void setName(const char* name);
   void setColor(uint16_t ct);
   void setColor(uint16_t hue, uint8_t sat);
   void setColorXY(float x, float y);
+  void setColorXYFixed(uint16_t x, uint16_t y);
   void setColor(uint8_t r, uint8_t g, uint8_t b);
+  void setGamut(EspalexaGamut gamut); //gamut of the light, for the conversion between xy and RGB
+  void beginUpdate(); //the changes until endUpdate() increment getVersion() only once
+  void endUpdate();
   
   void doCallback();
   
   uint8_t getLastValue(); //last value that was not off (1-255)
 };
 
+#define ESPALEXA_ROUND_UP(n, a) (((n) + (a) - 1) / (a) * (a))
+#ifdef ESPALEXA_STATIC_DEVICES
+static_assert(sizeof(EspalexaDevice) == ESPALEXA_ROUND_UP(27 + ESPALEXA_DEVICE_NAME_LEN + 1, sizeof(void*)) + sizeof(void*),
+  "EspalexaDevice has grown, update the layout comment");
+#else
+static_assert(sizeof(EspalexaDevice) == ESPALEXA_ROUND_UP(ESPALEXA_ROUND_UP(27, alignof(String)) + sizeof(String), sizeof(void*)) + sizeof(void*),
+  "EspalexaDevice has grown, update the layout comment");
+#endif
+#undef ESPALEXA_ROUND_UP
+
 #endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef EspalexaGroup_h
+#define EspalexaGroup_h
+
+#include "Arduino.h"
+#include "EspalexaDevice.h"
+
+#ifndef ESPALEXA_MAXDEVICES
+ #define ESPALEXA_MAXDEVICES 10 //same default as in Espalexa.h, include that instead
+#endif
+
+class EspalexaGroup;
+
+typedef void (*GroupCallbackFunction) (EspalexaGroup* g);
+
+//a room or zone of devices, served as Hue group. A state change for the group is applied to all of its devices.
+//Header only like Espalexa, so the device list is sized by the ESPALEXA_MAXDEVICES of the sketch and needs no heap
+class EspalexaGroup {
+private:
+  String _groupName;
+  GroupCallbackFunction _callback = nullptr;
+  EspalexaDevice* _devices[ESPALEXA_MAXDEVICES] = {};
+  uint8_t _deviceCount = 0;
+  uint8_t _id = 0;
+
+public:
+  EspalexaGroup() {}
+  //with a callback, group changes call it once instead of the callbacks of the single devices
+  EspalexaGroup(String groupName, GroupCallbackFunction gcb = nullptr) : _groupName(groupName), _callback(gcb) {}
+  //Espalexa keeps a pointer to the group, so a copy would not be served
+  EspalexaGroup(const EspalexaGroup&) = delete;
+  EspalexaGroup& operator=(const EspalexaGroup&) = delete;
+
+  String getName() {return _groupName;}
+  const char* getNameCStr() {return _groupName.c_str();} //no copy, valid until the name is changed
+  uint8_t getId() {return _id;}
+  uint8_t getDeviceCount() {return _deviceCount;}
+
+  EspalexaDevice* getDevice(uint8_t index)
+  {
+    if (index >= _deviceCount) return nullptr;
+    return _devices[index];
+  }
+
+  bool hasDevice(EspalexaDevice* d)
+  {
+    for (uint8_t i = 0; i < _deviceCount; i++)
+    {
+      if (_devices[i] == d) return true;
+    }
+    return false;
+  }
+
+  bool hasCallback() {return _callback != nullptr;}
+
+  void setId(uint8_t id) {_id = id;}
+  void setName(String name) {_groupName = name;}
+
+  //false if the group is full (ESPALEXA_MAXDEVICES devices) or already has the device
+  bool addDevice(EspalexaDevice* d)
+  {
+    if (d == nullptr || _deviceCount >= ESPALEXA_MAXDEVICES || hasDevice(d)) return false;
+    _devices[_deviceCount++] = d;
+    return true;
+  }
+
+  void doCallback()
+  {
+    if (_callback != nullptr) _callback(this);
+  }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef EspalexaJson_h
+#define EspalexaJson_h
+
+#include "Arduino.h"
+
+typedef void (*EspalexaJsonFlushFunction) (void* ctx, const char* data, size_t len);
+
+//Streaming JSON writer. Renders into a fixed, caller-supplied buffer and never allocates.
+//If a flush function is given, every full buffer is handed to it, otherwise output past the end is dropped (but still counted).
+class EspalexaJsonWriter {
+private:
+  char* _buf;
+  size_t _size;
+  size_t _len = 0;
+  size_t _total = 0; //all bytes produced, including flushed and dropped ones
+  EspalexaJsonFlushFunction _flush;
+  void* _ctx;
+
+public:
+  EspalexaJsonWriter(char* buf, size_t size, EspalexaJsonFlushFunction flush = nullptr, void* ctx = nullptr)
+    : _buf(buf), _size(size), _flush(flush), _ctx(ctx) {}
+
+  void write(const char* s, size_t n)
+  {
+    _total += n;
+    while (n > 0)
+    {
+      if (_len == _size)
+      {
+        if (_flush == nullptr || _size == 0) return; //full, drop the rest
+        flush();
+      }
+      size_t c = _size - _len;
+      if (c > n) c = n;
+      memcpy(_buf + _len, s, c);
+      _len += c; s += c; n -= c;
+    }
+  }
+
+  void write(char c)
+  {
+    write(&c, 1);
+  }
+
+  void print(const char* s)
+  {
+    write(s, strlen(s));
+  }
+
+  void print(uint32_t v)
+  {
+    char b[10];
+    uint8_t i = sizeof(b);
+    do {b[--i] = '0' + v % 10; v /= 10;} while (v);
+    write(b + i, sizeof(b) - i);
+  }
+
+  //fixed point fraction (0-65535 is 0.0-1.0) with the given number of decimals, up to 4
+  void printFixed(uint16_t v, uint8_t decimals)
+  {
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+    uint32_t n = ((uint32_t)v * scale + 32767) / 65535;
+    print(n / scale);
+    if (decimals == 0) return;
+    write('.');
+    n %= scale;
+    while (decimals--)
+    {
+      scale /= 10;
+      write('0' + n / scale);
+      n %= scale;
+    }
+  }
+
+  //JSON string contents, escapes quotes and backslashes and blanks out control characters
+  void printEscaped(const char* s)
+  {
+    const char* run = s;
+    for (; *s; s++)
+    {
+      if (*s != '"' && *s != '\\' && (uint8_t)*s >= 0x20) continue;
+      write(run, s - run);
+      if ((uint8_t)*s < 0x20) write(' ');
+      else {write('\\'); write(*s);}
+      run = s + 1;
+    }
+    write(run, s - run);
+  }
+
+  void flush()
+  {
+    if (_len == 0 || _flush == nullptr) return;
+    _flush(_ctx, _buf, _len);
+    _len = 0;
+  }
+
+  const char* data()   {return _buf;}
+  size_t length()      {return _len;}
+  size_t total()       {return _total;}
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef EspalexaQueue_h
+#define EspalexaQueue_h
+
+#include "Arduino.h"
+#include <atomic>
+
+//Fixed size, lock-free ring for exactly one producer and one consumer task. N must be a power of two.
+//push() may only be called from the producer, pop() only from the consumer.
+template <typename T, uint16_t N>
+class EspalexaQueue {
+  static_assert(N > 0 && N <= 32768 && (N & (N - 1)) == 0, "EspalexaQueue size must be a power of two");
+private:
+  T _items[N];
+  std::atomic<uint16_t> _head{0}; //next item to pop, only written by the consumer
+  std::atomic<uint16_t> _tail{0}; //next free item, only written by the producer
+
+public:
+  //false if the queue is full
+  bool push(const T& item)
+  {
+    uint16_t tail = _tail.load(std::memory_order_relaxed);
+    if ((uint16_t)(tail - _head.load(std::memory_order_acquire)) == N) return false;
+    _items[tail & (N - 1)] = item;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  //false if the queue is empty
+  bool pop(T& item)
+  {
+    uint16_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire)) return false;
+    item = _items[head & (N - 1)];
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint16_t size()
+  {
+    return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+  }
+};
+
+//Buffer with one writer and any number of readers that never block the writer (seqlock).
+//There are two copies, the writer fills the one readers don't use and then switches them over.
+//So a reader never waits for a writer that was interrupted (e.g. by the reading task) in the middle of a write,
+//it only reads again if the writer finished two writes while it was copying, and always gets a complete copy.
+template <size_t N>
+class EspalexaSeqlockBuffer {
+private:
+  struct Copy {
+    std::atomic<uint32_t> seq{0}; //odd while a write is in progress
+    std::atomic<uint32_t> len{0};
+    std::atomic<uint32_t> words[(N + 3) / 4];
+  };
+  Copy _copies[2];
+  std::atomic<uint8_t> _current{0}; //the copy readers use, only written by the writer
+
+public:
+  //len is cut to N
+  void write(const char* data, size_t len)
+  {
+    if (len > N) len = N;
+    uint8_t next = _current.load(std::memory_order_relaxed) ^ 1;
+    Copy& c = _copies[next];
+    uint32_t seq = c.seq.load(std::memory_order_relaxed);
+    c.seq.store(seq + 1, std::memory_order_relaxed);
+    //release stores, so a reader that sees any of them also sees the odd seq
+    c.len.store(len, std::memory_order_release);
+    for (size_t i = 0; i < len; i += 4)
+    {
+      uint32_t w = 0;
+      memcpy(&w, data + i, (len - i < 4) ? len - i : 4);
+      c.words[i / 4].store(w, std::memory_order_release);
+    }
+    c.seq.store(seq + 2, std::memory_order_release);
+    _current.store(next, std::memory_order_release);
+  }
+
+  //copies the contents to out (N bytes), returns their length
+  size_t read(char* out)
+  {
+    for (uint8_t attempt = 1;; attempt++)
+    {
+      const Copy& c = _copies[_current.load(std::memory_order_acquire)];
+      uint32_t before = c.seq.load(std::memory_order_acquire);
+      uint32_t len = c.len.load(std::memory_order_acquire);
+      if (len > N) len = N;
+      for (size_t i = 0; i < len; i += 4)
+      {
+        uint32_t w = c.words[i / 4].load(std::memory_order_acquire);
+        memcpy(out + i, &w, (len - i < 4) ? len - i : 4);
+      }
+      //the acquire loads keep this one after them
+      if (!(before & 1) && before == c.seq.load(std::memory_order_relaxed)) return len;
+      if (attempt % 4 == 0) yield(); //the writer keeps overtaking us, give other tasks a turn
+    }
+  }
+};
+
+#endif
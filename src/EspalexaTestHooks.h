@@ -0,0 +1,60 @@
+#ifndef EspalexaTestHooks_h
+#define EspalexaTestHooks_h
+
+//Entry points into Espalexa internals for benchmarks and tests (examples/EspalexaBenchmark, extras/host),
+//so they can measure single steps without WiFi and a web server. Sketches don't need this.
+//Define ESPALEXA_TEST_HOOKS before the first #include <Espalexa.h>, otherwise Espalexa has no hooks
+#ifndef ESPALEXA_TEST_HOOKS
+ #error "define ESPALEXA_TEST_HOOKS before including Espalexa.h"
+#endif
+
+#include "Espalexa.h"
+
+struct EspalexaTestHooks {
+  //the /lights listing as it would be sent if only the first count devices were added
+  static void renderLights(Espalexa& e, EspalexaJsonWriter& json, uint8_t count)
+  {
+    uint8_t total = e.currentDeviceCount;
+    e.currentDeviceCount = (count < total) ? count : total;
+    e.renderJson(json, &Espalexa::lightsJson, 0);
+    e.currentDeviceCount = total;
+  }
+
+  //deviceId is the Hue light number (1-based)
+  static void renderDevice(Espalexa& e, EspalexaJsonWriter& json, uint8_t deviceId)
+  {
+    e.deviceJson(json, deviceId);
+  }
+
+  //an Alexa command as the request handler applies it, without the HTTP request
+  static void applyCommand(Espalexa& e, EspalexaDevice* dev, const EspalexaCommand& cmd)
+  {
+    e.applyCommand(dev, cmd);
+  }
+
+  static void applyGroupCommand(Espalexa& e, EspalexaGroup* g, const EspalexaCommand& cmd)
+  {
+    e.applyGroupCommand(g, cmd);
+  }
+
+  //transition frames and pending callbacks, the part of loop() that doesn't need the network
+  static void updateDevices(Espalexa& e)
+  {
+    e.updateDevices();
+  }
+
+  //MX value of an M-SEARCH we answer, -1 for other packets
+  static int matchSearch(Espalexa& e, const char* packet)
+  {
+    return e.isSearchRequest(packet) ? e.searchMx(packet) : -1;
+  }
+
+  //renders the SSDP response and description.xml again
+  static void renderDiscovery(Espalexa& e)
+  {
+    e.discoveryRendered = false;
+    e.renderDiscovery();
+  }
+};
+
+#endif